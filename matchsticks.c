@@ -0,0 +1,5063 @@
+// ==================================================================================== //
+//                                21 Matchsticks: Engine                                //
+// ==================================================================================== //
+/*!
+	Implementation of libmatchsticks. See matchsticks.h.
+!*/
+
+#include "matchsticks.h"
+
+#include <string.h>		// strlen, memcpy, memcmp, memset
+#include <math.h>		// log10
+#include <time.h>		// timespec_get, clock_gettime
+#include <errno.h>		// errno, EINTR
+#include <pthread.h>	// pthread_create, pthread_join. See `retro_solve`.
+#include <sched.h>		// sched_yield
+
+// Waiting is an os function. So we need to handle it with care. See `clock_wait`.
+#ifdef _WIN32
+	#include <windows.h> // Sleep, GetSystemInfo
+#else
+	#include <unistd.h>		// write, close, sysconf
+	#include <fcntl.h>		// open
+	#include <sys/mman.h>	// mmap, madvise. Replay logs are read mapped, see `replay_map`.
+	#include <sys/stat.h>	// fstat
+	#include <poll.h>		// poll. Waits wake up on a key, see `clock_wait_fd`.
+	#include <signal.h>		// sigaction, raise. The terminal is put back on Ctrl+C, see `input_raw`.
+#endif
+
+// Debug Directive (Disabled)
+// Use gcc -D DEBUG
+// #define DEBUG
+
+
+
+// ==================================================================================== //
+//                                   Static Messages                                    //
+// ==================================================================================== //
+/*
+	Every message and dance pose, fully rendered at compile time.
+	Adjacent string literals are joined by the compiler, so `NICE` does at build time
+	what `strnice` + `joinstr` used to do at startup. No allocation, and it all sits in
+	read-only data.
+
+	`buildmessages` still builds the same strings at runtime. `--bench startup` checks 
+	that both agree byte for byte, so edit them together.
+*/
+
+// Compile-time `strnice`. Takes the SGR codes of fg, bg and modifiers, in that order.
+#define NICE1(str, a)			"\033[" a "m" str "\033[0m"
+#define NICE2(str, a, b)		"\033[" a ";" b "m" str "\033[0m"
+#define NICE3(str, a, b, c)		"\033[" a ";" b ";" c "m" str "\033[0m"
+
+// SGR codes of the FG_COLOR, BG_COLOR and MODIFIER values used below.
+#define SGR_RED				"31"
+#define SGR_GREEN			"32"
+#define SGR_YELLOW			"33"
+#define SGR_BLUE			"34"
+#define SGR_PURPLE			"35"
+#define SGR_CYAN			"36"
+#define SGR_BRIGHT_BLACK	"90"
+#define SGR_BG_WHITE		"47"
+#define SGR_BOLD			"1"		// modheavy, 1
+#define SGR_HEAVY			"1;4"	// modheavy, 2
+#define SGR_FAINT			"2"		// modlight, 1
+#define SGR_LIGHT			"2;9"	// modlight, 2
+
+// Unicode Emojis.
+#define EMOJI_SMILE "\U0001F600"
+#define EMOJI_TONGUE "\U0001F61B"
+
+// ------------------------------------------------------------------------------------ //
+
+#define EMJ_SMILE	NICE2(":)", SGR_GREEN, SGR_BOLD)
+#define EMJ_HAPPY	NICE2(":D", SGR_GREEN, SGR_BOLD)
+#define EMJ_ANGRY	NICE2(">:(", SGR_RED, SGR_BOLD)
+#define EMJ_EVIL	NICE2(">:)", SGR_PURPLE, SGR_BOLD)
+#define EMJ_TAUNT	NICE2(":P", SGR_YELLOW, SGR_BOLD)
+#define EMJ_SAD		NICE2(":(", SGR_RED, SGR_BOLD)
+#define EMJ_CRY		NICE2(":'(", SGR_BLUE, SGR_BOLD)
+
+#define RULES_TEXT \
+	"\t1. We have 21 matchsticks in the pool.\n" \
+	"\t2. Each player can pick 1,2,3 or 4 matchsticks in their turn.\n" \
+	"\t3. The player to pick the last matchstick loses.\n"
+
+// Dance Sequence: L R L R P O P O 
+#define POSE_L \
+	"_          "                        "\n" \
+	" \\   " EMOJI_SMILE "     "          "\n" \
+	"  ---|---  "                        "\n" \
+	"     |   \\_"                       "\n" \
+	"     |     "                        "\n" \
+	"    / \\    "                       "\n" \
+	"   /   \\   "                       "\n"
+
+#define POSE_R \
+	"           _"                       "\n" \
+	"     " EMOJI_SMILE "   / "          "\n" \
+	"  ---|---  "                        "\n" \
+	"_/   |     "                        "\n" \
+	"     |     "                        "\n" \
+	"    / \\    "                       "\n" \
+	"   /   \\   "                       "\n"
+
+#define POSE_P \
+	"_          _"                       "\n" \
+	" \\   " EMOJI_TONGUE "   / "        "\n" \
+	"  ---|---  "                        "\n" \
+	"     |     "                        "\n" \
+	"     |     "                        "\n" \
+	"    / \\    "                       "\n" \
+	"   /   \\   "                       "\n"
+
+#define POSE_O \
+	"_          _"                       "\n" \
+	" \\   " EMOJI_SMILE "   / "         "\n" \
+	"  ---|---  "                        "\n" \
+	"     |     "                        "\n" \
+	"     |     "                        "\n" \
+	"    / \\    "                       "\n" \
+	"   /   \\   "                       "\n"
+
+// ------------------------------------------------------------------------------------ //
+
+const char* const DANCES[nDANCES] = {POSE_L, POSE_R, POSE_L, POSE_R, POSE_P, POSE_O, POSE_P, POSE_O};
+
+// Entries left out (plr_pref_choice ... cmp_choice) depend on the player's color.
+// They live in `themes`, see `getmessage`.
+const char* const MESSAGES[nMSG] = {
+	[emj_smile] = EMJ_SMILE,
+	[emj_happy] = EMJ_HAPPY,
+	[emj_angry] = EMJ_ANGRY,
+	[emj_evil]  = EMJ_EVIL,
+	[emj_taunt] = EMJ_TAUNT,
+	[emj_sad]   = EMJ_SAD,
+	[emj_cry]   = EMJ_CRY,
+
+	// -------------------------------------------------------------------------------- //
+
+	[greeting] = 
+		"Hi! Welcome to my game! " EMJ_SMILE
+		"\nLet me explain the rules...\n"
+		RULES_TEXT
+		NICE1("Lets Begin! ", SGR_GREEN) EMJ_HAPPY "\n",
+
+	[alt_greeting] = 
+		"... \n"
+		"Let me explain the rules again... " EMJ_TAUNT "\n"
+		RULES_TEXT
+		NICE1("Let's go again! ", SGR_GREEN) EMJ_TAUNT "\n",
+
+	// -------------------------------------------------------------------------------- //
+
+	[mode_choice] = 
+		"Choose Mode:"
+		"\n\t0. Exit"
+		"\n\t"
+		NICE3("1. Normal Mode", SGR_GREEN, SGR_BG_WHITE, SGR_FAINT)
+		NICE2("\n\t2. IMPOSSIBLE MODE\n", SGR_RED, SGR_HEAVY),
+
+	[nerfed_mode_choice] = 
+		"Choose Mode:"
+		"\n\t0. Exit"
+		NICE2("\n\t2. IMPOSSIBLE MODE\n", SGR_RED, SGR_HEAVY),
+
+	[color_choice_msg] = 
+		"Let us choose our colors...\nMy Color is: "
+		NICE2("\n\t6. CYAN", SGR_CYAN, SGR_BOLD)
+		"\nChoose Yours:"
+		NICE2("\n\t1. RED", SGR_RED, SGR_BOLD)
+		NICE2("\n\t2. GREEN", SGR_GREEN, SGR_BOLD)
+		NICE2("\n\t3. YELLOW", SGR_YELLOW, SGR_BOLD)
+		NICE2("\n\t4. BLUE", SGR_BLUE, SGR_BOLD)
+		NICE2("\n\t5. PURPLE", SGR_PURPLE, SGR_BOLD),
+
+	// -------------------------------------------------------------------------------- //
+
+	[goodbye] = 
+		EMJ_CRY NICE2(" So sorry to say goodbye!\n", SGR_BLUE, SGR_FAINT)
+		EMJ_SAD NICE2(" I see that you have work to attend to...\n", SGR_RED, SGR_FAINT)
+		EMJ_HAPPY NICE2(" Hope to see you again!\n", SGR_GREEN, SGR_FAINT)
+		"Bye~\n",
+
+	[normie] = 
+		EMJ_TAUNT NICE2(" HAHA LOSER!\n", SGR_RED, SGR_BOLD)
+		NICE3("This game is not for normies.", SGR_GREEN, SGR_BG_WHITE, SGR_LIGHT)
+		"\n"
+		EMJ_EVIL NICE3("  CHOOSE IMPOSSIBLE MODE OR...", SGR_RED, SGR_BG_WHITE, SGR_HEAVY),
+
+	[guts] = 
+		EMJ_EVIL NICE1(" Yeah!! Now we're talking! Let's Go!", SGR_CYAN),
+
+	[true_normie] = 
+		EMJ_TAUNT
+		NICE1(" It seems that you ", SGR_BLUE)
+		NICE2("really", SGR_RED, SGR_HEAVY)
+		NICE1(" want to be a ", SGR_BLUE)
+		NICE3("normie", SGR_BRIGHT_BLACK, SGR_BG_WHITE, SGR_HEAVY)
+		NICE1(" so why would I stop you? ", SGR_BLUE)
+		EMJ_TAUNT "\n",
+
+	// -------------------------------------------------------------------------------- //
+
+	[invalid_choice] = 
+		EMJ_SAD
+		NICE1("\nYou chose a wrong input!\n", SGR_CYAN)
+		NICE1("Please choose again.\n", SGR_FAINT)
+		"\n"
+		EMJ_EVIL NICE3("CHOOSE IMPOSSIBLE MODE OR ...", SGR_RED, SGR_BG_WHITE, SGR_HEAVY)
+		"\n",
+
+	[invalid_choice_guts] = 
+		EMJ_SAD
+		NICE1(" You chose a wrong input!\n", SGR_CYAN)
+		NICE1("Please choose again.\n", SGR_FAINT)
+		"\n",
+
+	[good_choice] = EMJ_EVIL NICE2(" Good Choice", SGR_PURPLE, SGR_BOLD),
+	[bad_choice]  = EMJ_ANGRY NICE2(" You think you're smart huh?", SGR_PURPLE, SGR_BOLD),
+
+	[get_out] = 
+		EMJ_ANGRY NICE2(" I won't be playing with you.\n", SGR_PURPLE, SGR_BOLD)
+		NICE2("GET OUT!", SGR_RED, SGR_HEAVY),
+
+	// -------------------------------------------------------------------------------- //
+
+	[dance_msg] = EMJ_EVIL NICE2(" HAHA LOSER!! I WON!", SGR_PURPLE, SGR_HEAVY) "\n",
+	[replay] = NICE1("Let's Play Again! ", SGR_BLUE) EMJ_HAPPY "\n",
+
+	[true_normie_win] = 
+		EMJ_SMILE NICE1(" Congrats on your win! You truly deserve it", SGR_GREEN),
+
+	[true_normie_loss] = 
+		EMJ_TAUNT "\n" EMJ_EVIL NICE1("  JUST KIDDING!!!", SGR_RED),
+
+	[normie_max] = NICE3("NORMIE", SGR_BRIGHT_BLACK, SGR_BG_WHITE, SGR_HEAVY) "     ",
+
+	// -------------------------------------------------------------------------------- //
+
+	[loading_impossible] = NICE2("LOADING IMPOSSIBLE MODE", SGR_PURPLE, SGR_BOLD),
+	[cmp_ichoose] = NICE1("I Choose", SGR_CYAN)
+};
+
+
+
+// ==================================================================================== //
+//                                      Constants                                       //
+// ==================================================================================== //
+
+const MODIFIER modheavy[2] = {BOLD, UNDERLINE}, modlight[2] = {FAINT, STRIKE};
+const char *const SMILE = EMOJI_SMILE, *const TONGUE = EMOJI_TONGUE; // Unicode Emojis.
+
+// The rules of 21 Matchsticks. Each session solves them in `session_init`.
+const Rules CLASSIC_RULES = {.pool = 21, .moves = 0b1111, .misere = true};
+
+
+
+// ==================================================================================== //
+//                          Function Implementations - Helpers                          //
+// ==================================================================================== //
+
+// ------------------------------------------------------------------------------------ //
+//                           Subsection: String Functionality                           //
+// ------------------------------------------------------------------------------------ //
+
+static inline void metrics_count(Session* session, HELPER helper, size_t allocs, size_t bytes) {
+	/*
+		Counts what a helper allocated, if the session keeps metrics. See `Subsection: Metrics`.
+	*/
+	if (session->metrics.enabled) {
+		session->metrics.allocs[helper] += allocs;
+		session->metrics.bytes[helper] += bytes;
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+char* itoa(Session* session, int i) {
+	/* 
+		Converts an integer (i) to a string (a).
+
+		@param Session* session:	The game being played.
+		@param int i:	The integer to convert to string.
+		@return char*:	The required string.
+	*/
+	
+	tiny digs = log10(i) + 1;
+	char* a = arena_alloc(&session->frame_arena, digs + 1);
+	metrics_count(session, HELPER_ITOA, 1, digs + 1);
+	for (tiny n = digs - 1; n >= 0; n--) {
+		*(a + n) = (i % 10) + '0';
+		i /= 10;
+	}
+	*(a + digs) = 0;
+	return a;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static char* vjoinstr(Arena* arena, tiny n, va_list args) {
+	/*
+		Gets the concatenated string. 
+		Substitute of `strcat`.
+		
+		Note that the use of pointer notation 
+			*(ptr + i) = val;
+		is intentional for demonstrating its capabilities. 
+		It is not a good practice and the sugar
+			ptr[i] = val;
+		is preferred.
+
+		@param Arena* arena:	Arena to allocate from. NULL means `malloc`.
+		@param tiny n: 			Number of strings to concatenate.
+		@param va_list args:	Said strings to concatenate.
+		@return char*: 			Concatenated string.
+	*/
+
+	// We walk the varargs twice, so keep a copy for the second walk.
+	// Walking a va_list twice without a copy causes undefined behaviour.
+	va_list again;
+	va_copy(again, args);
+	
+	int len = 0, idx = 0;
+	for (tiny _ = 0; _<n; _++) {
+		char* str = va_arg(args, char*);
+
+		#ifdef DEBUG
+			fprintf(stderr, "Concatting string: %s\n", str);
+		#endif
+		if (!str) continue;
+		len += strlen(str);
+	};
+	
+	// +1 for NULL
+	char* finalstr = arena ? arena_alloc(arena, len + 1) : malloc(len + 1);
+
+	// va_arg retrieves and casts arg. va_list should not be indexed.
+	for (tiny _ = 0; _<n; _++) {
+		char* str = va_arg(again, char*);
+		if (!str) continue;
+		char f;
+		int c = 0;
+
+		// Read till NULL terminator.
+		do *(finalstr + idx++) = f = *(str + c++); while (f);
+		idx--; // The last 0 also gets added. So we overwrite it in the next loop.
+	}
+	*(finalstr + idx) = 0; // NULL terminator, in case every string was NULL.
+	va_end(again);
+	return finalstr; 
+}
+
+// ------------------------------------------------------------------------------------ //
+
+char* joinstr(tiny n, ...) {
+	/*
+		Concatenates `n` strings into a new heap string. Caller owns the result.
+
+		@param tiny n: 	Number of strings to concatenate.
+		@vararg: 		Said strings to concatenate.
+		@return char*: 	Concatenated string.
+	*/
+	va_list args;
+	va_start(args, n); // Initialize varargs to va_list. It stores all varargs.
+	char* finalstr = vjoinstr(NULL, n, args);
+	va_end(args);
+	return finalstr;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+char* arena_joinstr(Arena* arena, tiny n, ...) {
+	/*
+		Same as `joinstr`, but the result lives in `arena` and is released with it.
+
+		@param Arena* arena:	Arena to allocate from.
+		@param tiny n: 			Number of strings to concatenate.
+		@vararg: 				Said strings to concatenate.
+		@return char*: 			Concatenated string.
+	*/
+	va_list args;
+	va_start(args, n);
+	char* finalstr = vjoinstr(arena, n, args);
+	va_end(args);
+	return finalstr;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+char* trimquotes(Session* session, const char rawstr[]) {
+	/*
+		Removes the quotes of a rawstring.
+		Useful after the #str macro. 
+
+		@param Session* session:	The game being played.
+		@param const char rawstr[]: Raw string, provided by the macro.
+		@return char*:	Trimmed string.
+	*/
+	
+	int len = strlen(rawstr) - 2;
+	char *trimstr = arena_alloc(&session->frame_arena, len + 1);
+
+	for (int i = 1; i <= len; i++) trimstr[i - 1] = rawstr[i];
+	trimstr[len] = 0; // NULL terminator of string.
+
+	return trimstr; 
+}
+
+// ------------------------------------------------------------------------------------ //
+
+char* emojify(Session* session, char* rawstr, const char* emoji, char echar) {
+	/*
+		Replaces a certain character with provided unicode emoji. 
+
+		@param Session* session:	The game being played.
+		@param char* rawstr: String in which we wish to replace the emoji.
+		@param const char* emoji:	The Emoji string.
+		@param char echar:	 The character which gets replaced by the emoji.
+		@return char*:		 Emojified string.
+	*/
+	
+	int n = strlen(rawstr), ne = strlen(emoji), nechar = 0;
+	for (int r = 0; r < n; r++) nechar += rawstr[r] == echar;
+
+	// Each echar is replaced by the whole emoji. +1 for NULL.
+	char *emojified = arena_alloc(&session->frame_arena, n + nechar*(ne - 1) + 1);
+	metrics_count(session, HELPER_EMOJIFY, 1, n + nechar*(ne - 1) + 1);
+	char c;
+	int r = 0, ef = 0;
+	
+	while (r < n) 
+		if ((c = rawstr[r++]) != echar) emojified[ef++] = c; // Copying char.
+			// Copying emoji.
+		else for (int e = 0; e < ne; e++, ef++) emojified[ef] = emoji[e];
+		 
+	emojified[ef] = 0; // NULL terminated string.
+	
+	return emojified;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static char* put_code(char* at, int code) {
+	/*
+		Writes a 1 to 3 digit SGR code followed by ';'. 
+
+		@param char* at:	Where to write.
+		@param int code:	The code. 0 to 107.
+		@return char*:		Just past the ';'.
+	*/
+	if (code >= 100) *at++ = '0' + code / 100;
+	if (code >= 10) *at++ = '0' + code / 10 % 10;
+	*at++ = '0' + code % 10;
+	*at++ = ';';
+	return at;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void build_sgr(SgrPrefix* entry, FG_COLOR fg, BG_COLOR bg, uint32_t modset) {
+	/*
+		Writes the opening escape sequence of a style into `entry`.
+
+		@param SgrPrefix* entry:	Where to write it.
+		@param FG_COLOR fg:			ANSI Foreground Color.
+		@param BG_COLOR bg:			ANSI Background Color.
+		@param uint32_t modset:		Bit m set applies MODIFIER m.
+	*/
+	char* at = entry->seq;
+	*at++ = 033;
+	*at++ = '[';
+	if (fg) at = put_code(at, fg);
+	if (bg) at = put_code(at, bg);
+	for (tiny m = 0; m < 10; m++) if (modset >> m & 1) at = put_code(at, m);
+	at[-1] = 'm'; // Replace last ; with m.
+	*at = 0;
+	entry->len = at - entry->seq;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+const SgrPrefix* sgr_prefix(Session* session, FG_COLOR fg, BG_COLOR bg, 
+		const MODIFIER* mod, tiny nmod) {
+	/*
+		Gets the opening escape sequence for a style, like "\033[31;1;4m".
+		Each distinct style is built once and interned in `sgr_cache`.
+		Modifiers are a set: they are written in ascending order, without repeats.
+
+		@param Session* session:	The game being played.
+		@param FG_COLOR fg:		ANSI Foreground Color.
+		@param BG_COLOR bg:		ANSI Background Color.
+		@param const MODIFIER* mod:	List of ANSI special effects.
+		@param tiny nmod:		How many of them to apply.
+		@return SgrPrefix*:		The interned sequence. Empty if there is no style.
+								Once the cache is full, new styles last until the next call.
+	*/
+	static const SgrPrefix none = {0};
+
+	uint32_t modset = 0;
+	for (tiny i = 0; i < nmod; i++) modset |= 1u << mod[i];
+	uint32_t key = SGR_KEY(fg, bg, modset);
+	if (!key) return &none;
+
+	// Open addressing with linear probing. Key 0 marks a free slot.
+	uint32_t slot = (key * 2654435761u) >> (32 - SGR_CACHE_BITS);
+	for (uint32_t probe = 0; probe < SGR_CACHE_SIZE; probe++) {
+		SgrPrefix* entry = &session->sgr_cache[(slot + probe) & (SGR_CACHE_SIZE - 1)];
+		if (entry->key == key) return entry;
+		if (entry->key) continue;
+
+		// First use of this style. Build it.
+		build_sgr(entry, fg, bg, modset);
+		entry->key = key;
+		session->nsgr_cache++;
+		return entry;
+	}
+
+	// Table full. Still correct, just not interned: valid until the next lookup.
+	build_sgr(&session->sgr_uncached, fg, bg, modset);
+	return &session->sgr_uncached;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static size_t nice_len(const SgrPrefix* pre, size_t rawlen) {
+	/*
+		Length of a string of `rawlen` characters in the style of `pre`, without the NULL.
+		Unstyled strings are copied as is, styled ones end in \033[0m.
+	*/
+	return pre->len + rawlen + (pre->len ? 4 : 0);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void put_nice(char* buf, const SgrPrefix* pre, const char* rawstr, size_t rawlen) {
+	/*
+		Writes the styled string, NULL terminated. `buf` holds `nice_len` + 1 bytes.
+	*/
+	memcpy(buf, pre->seq, pre->len);
+	memcpy(buf + pre->len, rawstr, rawlen);
+	size_t len = nice_len(pre, rawlen);
+	memcpy(buf + pre->len + rawlen, "\033[0m", len - pre->len - rawlen);
+	buf[len] = 0; // NULL terminator of string.
+}
+
+// ------------------------------------------------------------------------------------ //
+
+size_t strnice_into(Session* session, char* buf, size_t cap, const char* rawstr, 
+		FG_COLOR fg, BG_COLOR bg, const MODIFIER* mod, tiny nmod) {
+	/*
+		Same as `strnice`, but writes into a buffer owned by the caller. No allocation.
+		Like snprintf, returns the full length even if `cap` was too small to hold it.
+
+		@param Session* session:	The game being played.
+		@param char* buf:		Where to write. May be NULL if cap is 0.
+		@param size_t cap:		Size of buf, including room for the NULL.
+		@param char* rawstr:	Plain String.
+		@param FG_COLOR fg:		ANSI Foreground Color.
+		@param BG_COLOR bg:		ANSI Background Color.
+		@param const MODIFIER* mod:	List of ANSI special effects.
+		@param tiny nmod:		How many of them to apply.
+		@return size_t:			Length of the colorized string, without the NULL.
+	*/
+	const SgrPrefix* pre = sgr_prefix(session, fg, bg, mod, nmod);
+	size_t rawlen = strlen(rawstr), len = nice_len(pre, rawlen);
+	if (len + 1 <= cap) put_nice(buf, pre, rawstr, rawlen);
+	return len;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+char* strnice(Session* session, const char* rawstr, FG_COLOR fg, BG_COLOR bg, 
+		const MODIFIER* mod, tiny nmod) {
+	/*
+		Colorizes and applies special effects to strings.
+		Based on ANSI escape sequences.
+		The escape sequence comes from `sgr_prefix`, so this is a lookup and a copy.
+		
+		@param Session* session:	The game being played.
+		@param char* rawstr:	Plain String.
+		@param FG_COLOR fg:		ANSI Foreground Color.
+		@param BG_COLOR bg:		ANSI Background Color.
+		@param const MODIFIER* mod:	List of ANSI special effects.
+		@param tiny nmod:		How many of them to apply.
+		@return char*:			Colorized string. Lives in the `frame_arena` of the session.
+	*/
+	const SgrPrefix* pre = sgr_prefix(session, fg, bg, mod, nmod);
+	size_t rawlen = strlen(rawstr), len = nice_len(pre, rawlen);
+	char* filled = arena_alloc(&session->frame_arena, len + 1);
+	metrics_count(session, HELPER_STRNICE, 1, len + 1);
+	put_nice(filled, pre, rawstr, rawlen);
+	return filled;
+}
+
+// ------------------------------------------------------------------------------------ //
+//                            Subsection: Memory Management                             //
+// ------------------------------------------------------------------------------------ //
+
+static ArenaBlock* arena_block(Arena* arena, size_t cap) {
+	/*
+		Allocates one empty block of `cap` bytes and counts it in the arena.
+
+		@param Arena* arena:	Arena the block is for.
+		@param size_t cap:		Usable size of the block.
+		@return ArenaBlock*:	The block. Not linked yet.
+	*/
+	ArenaBlock* block = malloc(sizeof(ArenaBlock) + cap);
+	if (!block) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+	block->next = NULL;
+	block->cap = cap;
+	block->used = 0;
+
+	arena->nblocks++;
+	arena->capacity += cap;
+	return block;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void arena_init(Arena* arena, size_t cap) {
+	/*
+		Prepares an empty arena. Nothing is allocated until the first `arena_alloc`, 
+		so arenas that are never used cost nothing at startup.
+
+		@param Arena* arena:	Arena to initialize.
+		@param size_t cap:		Size of the first block. The arena grows beyond it if needed.
+	*/
+	*arena = (Arena) {0};
+	arena->block_size = cap;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void* arena_alloc(Arena* arena, size_t size) {
+	/*
+		Bump-allocates `size` bytes from the arena.
+		If the current block is full, moves on to the next (already chained) block that 
+		fits, or chains a new one twice as large. Nothing is ever written out of bounds.
+
+		@param Arena* arena:	Arena to allocate from.
+		@param size_t size:		Number of bytes needed.
+		@return void*:			Pointer to the bytes. Valid until the arena is reset.
+	*/
+
+	// Round up so the next allocation stays aligned.
+	const size_t align = sizeof(max_align_t);
+	size = (size + align - 1) & ~(align - 1);
+
+	if (!arena->head) {
+		arena->head = arena->cur = arena_block(arena, size > arena->block_size ? size : arena->block_size);
+	}
+
+	ArenaBlock* block = arena->cur;
+	while (block->used + size > block->cap) {
+		ArenaBlock* next = block->next;
+
+		// Blocks after `cur` are left over from before the last reset. Reuse them.
+		if (next) {
+			next->used = 0;
+			block = next;
+			continue;
+		}
+
+		size_t cap = arena->cur->cap * 2;
+		if (cap < size) cap = size;
+		block = block->next = arena_block(arena, cap);
+	}
+	arena->cur = block;
+
+	void* ptr = (char*) block->data + block->used;
+	block->used += size;
+
+	arena->nalloc++;
+	arena->total_allocs++;
+	arena->total_bytes += size;
+	arena->bytes += size;
+	if (arena->bytes > arena->peak_bytes) arena->peak_bytes = arena->bytes;
+	return ptr;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void arena_reset(Arena* arena) {
+	/*
+		Releases everything allocated from the arena in O(1).
+		Blocks are kept. Later blocks get rewound lazily, once `arena_alloc` reaches them.
+
+		@param Arena* arena:	Arena to reset.
+	*/
+	if (arena->head) arena->head->used = 0;
+	arena->cur = arena->head;
+	arena->nalloc = 0;
+	arena->bytes = 0;
+	arena->nresets++;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void arena_free(Arena* arena) {
+	/*
+		Returns all blocks of the arena to the system. Used before exiting.
+
+		@param Arena* arena:	Arena to free.
+	*/
+	ArenaBlock* block = arena->head;
+	while (block) {
+		ArenaBlock* next = block->next;
+		free(block);
+		block = next;
+	}
+	size_t block_size = arena->block_size;
+	*arena = (Arena) {0};
+	arena->block_size = block_size; // Usable again, like after `arena_init`.
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void _gc(Session* session) {
+	/*
+		Cleares the per-frame strings. All of them go at once with the arena.
+	*/ 
+
+	#ifdef DEBUG
+		fprintf(stderr, "CLEARED FRAME ARENA (%zu ITEMS, %zu BYTES, PEAK %zu, %zu BLOCKS)\n", 
+			session->frame_arena.nalloc, session->frame_arena.bytes, 
+			session->frame_arena.peak_bytes, session->frame_arena.nblocks);
+	#endif
+	arena_reset(&session->frame_arena);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void _gc_full_(Session* session) {
+	/*
+		Cleares all pointers of the session. Used when it ends, see `session_free`.
+
+		@param Session* session:	The game being played.
+	*/ 
+	// MESSAGES and DANCES are static. Colored messages live in `theme_arena`.
+	arena_free(&session->frame_arena);
+	arena_free(&session->theme_arena);
+	for (tiny t = 0; t < nTHEMES; t++) session->themes[t] = (Theme) {0};
+	strategy_free(&session->strategy);
+	solver_free(&session->solver);
+
+	fb_flush(session); // Through the SGR filter, so its counts include the last frame.
+
+	#ifdef DEBUG
+		fprintf(stderr, "CLOCK: %zu WAITS, %.3fs GAME TIME, %.3fs SLEPT\n", session->clock.nwaits, 
+			session->clock.virtual_ns / 1e9, session->clock.slept_ns / 1e9);
+		fprintf(stderr, "SGR: %zu BYTES IN, %zu OUT\n", session->sgr.bytes_in, session->sgr.bytes_out);
+		const Input* input = &session->input;
+		fprintf(stderr, "INPUT: %zu KEYS, %zu SKIPS, %.2fms AVG / %.2fms MAX TO ANSWER\n", input->keys,
+			input->skips, input->nanswered ? input->latency_ns / 1e6 / input->nanswered : 0.0,
+			input->max_latency_ns / 1e6);
+	#endif
+	sgr_filter_free(&session->sgr);
+	free(session->frame.buf);
+	session->frame.buf = NULL;
+	session->frame.len = session->frame.cap = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void buildmessages(Session* session, const char* messages[nMSG], const char* dances[nDANCES]) {
+	/*
+		Builds the messages that need to be displayed, at runtime, on the heap.
+		The game uses the static `MESSAGES` and `DANCES` instead. This is the reference
+		they are checked against, and the baseline of `--bench startup`.
+		Free with `freemessages`.
+
+		@param Session* session:	The game being played.
+		@param const char* messages[nMSG]:		Filled with the messages.
+		@param const char* dances[nDANCES]:		Filled with the dance poses.
+	*/
+		
+	// -------------------------------------------------------------------------------- //
+	//                                 Portion: Dances                                  //
+	// -------------------------------------------------------------------------------- //
+	/*
+		When the computer wins, it will dance and taunt the player.
+		These strings are used to set said dance poses.
+		Dance Sequence: L R L R P O P O 
+	*/
+
+	
+	char* pose_L = joinstr(7*2,
+	                            "_          "     ,              "\n",
+		emojify(session, trimquotes(session, R(   " \   O     "   )), SMILE, 'O'), "\n",
+		                        "  ---|---  "     ,              "\n",
+		        trimquotes(session, R(   "     |   \_"   )),              "\n",
+		                        "     |     "     ,              "\n",
+		        trimquotes(session, R(   "    / \    "   )),              "\n",
+		        trimquotes(session, R(   "   /   \   "   )),              "\n"	
+	);
+	char* pose_R = joinstr(7*2,
+		                        "           _"    ,             "\n",
+		emojify(session, trimquotes(session, R(   "     O   / "   )), SMILE, 'O'), "\n",
+		                        "  ---|---  "     ,              "\n",
+		        trimquotes(session, R(   "_/   |     "   )),              "\n",
+		                        "     |     "     ,              "\n",
+		        trimquotes(session, R(   "    / \    "   )),              "\n",
+		        trimquotes(session, R(   "   /   \   "   )),              "\n"	
+	);
+	char* pose_P = joinstr(7*2, 
+	                            "_          _"    ,              "\n",
+		emojify(session, trimquotes(session, R(   " \   P   / "   )), TONGUE, 'P'),"\n",
+		                        "  ---|---  "     ,              "\n",
+		        trimquotes(session, R(   "     |     "   )),              "\n",
+		                        "     |     "     ,              "\n",
+		        trimquotes(session, R(   "    / \    "   )),              "\n",
+		        trimquotes(session, R(   "   /   \   "   )),              "\n"	
+	);
+	char* pose_O = joinstr(7*2,
+	                            "_          _"    ,              "\n",
+		emojify(session, trimquotes(session, R(   " \   O   / "   )), SMILE, 'O'), "\n",
+		                        "  ---|---  "     ,              "\n",
+		        trimquotes(session, R(   "     |     "   )),              "\n",
+		                        "     |     "     ,              "\n",
+		        trimquotes(session, R(   "    / \    "   )),              "\n",
+		        trimquotes(session, R(   "   /   \   "   )),              "\n"	
+	);
+	
+	dances[0] = pose_L;
+	dances[1] = pose_R;
+	dances[2] = pose_L;
+	dances[3] = pose_R;
+	
+	dances[4] = pose_P;
+	dances[5] = pose_O;
+	dances[6] = pose_P;
+	dances[7] = pose_O;
+
+	// Many objects have built up in cache. Good idea to clear them here.
+	_gc(session);
+
+	// -------------------------------------------------------------------------------- //
+	//                                Portion: Messages                                 //
+	// -------------------------------------------------------------------------------- //
+	/*
+		Many messages exist in the game that are displayed repeatedly.
+		This will store them.
+	*/
+
+	messages[emj_smile] = joinstr(1, strnice(session, ":)", FG_GREEN, BG_DEFAULT, modheavy, 1));
+	messages[emj_happy] = joinstr(1, strnice(session, ":D", FG_GREEN, BG_DEFAULT, modheavy, 1));
+	messages[emj_angry] = joinstr(1, strnice(session, ">:(", FG_RED, BG_DEFAULT, modheavy, 1));
+	messages[emj_evil]  = joinstr(1, strnice(session, ">:)", FG_PURPLE, BG_DEFAULT, modheavy, 1));
+	messages[emj_taunt] = joinstr(1, strnice(session, ":P", FG_YELLOW, BG_DEFAULT, modheavy, 1));
+	messages[emj_sad]   = joinstr(1, strnice(session, ":(", FG_RED, BG_DEFAULT, modheavy, 1));
+	messages[emj_cry]   = joinstr(1, strnice(session, ":'(", FG_BLUE, BG_DEFAULT, modheavy, 1));
+
+	#ifdef DEBUG
+		fprintf(stderr, "Saved Emojis.\n");
+		fprintf(stderr, "Like this emoji: %s\n", strnice(session, ":)", FG_GREEN, BG_DEFAULT, modheavy, 1));
+	#endif
+
+	// -------------------------------------------------------------------------------- //
+
+	messages[greeting] = joinstr(9, 
+		"Hi! Welcome to my game! ", 
+		messages[emj_smile],
+		"\nLet me explain the rules...\n",
+		"\t1. We have 21 matchsticks in the pool.\n",
+		"\t2. Each player can pick 1,2,3 or 4 matchsticks in their turn.\n",
+		"\t3. The player to pick the last matchstick loses.\n",
+		strnice(session, "Lets Begin! ", FG_GREEN, BG_DEFAULT, modheavy, 0),
+		messages[emj_happy],
+		"\n"	
+	);
+
+	messages[alt_greeting] = joinstr(10, 
+		"... \n", 
+		"Let me explain the rules again... ", 
+		messages[emj_taunt], 
+		"\n",
+		"\t1. We have 21 matchsticks in the pool.\n",
+		"\t2. Each player can pick 1,2,3 or 4 matchsticks in their turn.\n",
+		"\t3. The player to pick the last matchstick loses.\n",
+		strnice(session, "Let's go again! ", FG_GREEN, BG_DEFAULT, modheavy, 0),
+		messages[emj_taunt],
+		"\n"
+	);
+
+	// -------------------------------------------------------------------------------- //
+	
+	messages[mode_choice] = joinstr(5,
+		"Choose Mode:",
+		"\n\t0. Exit",
+		"\n\t",
+		strnice(session, "1. Normal Mode", FG_GREEN, BG_WHITE, modlight, 1), 
+		strnice(session, "\n\t2. IMPOSSIBLE MODE\n", FG_RED, BG_DEFAULT, modheavy, 2)
+	);
+
+	messages[nerfed_mode_choice] = joinstr(3,
+		"Choose Mode:",
+		"\n\t0. Exit",
+		strnice(session, "\n\t2. IMPOSSIBLE MODE\n", FG_RED, BG_DEFAULT, modheavy, 2)
+	);
+
+	messages[color_choice_msg] = joinstr(8, 
+		"Let us choose our colors...\nMy Color is: ", 
+		strnice(session, "\n\t6. CYAN", FG_CYAN, BG_DEFAULT, modheavy, 1),
+		"\nChoose Yours:",
+		strnice(session, "\n\t1. RED", FG_RED, BG_DEFAULT, modheavy, 1),
+		strnice(session, "\n\t2. GREEN", FG_GREEN, BG_DEFAULT, modheavy, 1),
+		strnice(session, "\n\t3. YELLOW", FG_YELLOW, BG_DEFAULT, modheavy, 1),
+		strnice(session, "\n\t4. BLUE", FG_BLUE, BG_DEFAULT, modheavy, 1),
+		strnice(session, "\n\t5. PURPLE", FG_PURPLE, BG_DEFAULT, modheavy, 1)
+	);
+
+	// -------------------------------------------------------------------------------- //
+
+	messages[goodbye] = joinstr(7, 
+		messages[emj_cry], 
+		strnice(session, " So sorry to say goodbye!\n", FG_BLUE, BG_DEFAULT, modlight, 1),
+		messages[emj_sad],
+		strnice(session, " I see that you have work to attend to...\n", FG_RED, BG_DEFAULT, modlight, 1),
+		messages[emj_happy],
+		strnice(session, " Hope to see you again!\n", FG_GREEN, BG_DEFAULT, modlight, 1),
+		"Bye~\n"
+	);
+
+	messages[normie] = joinstr(6, 
+		messages[emj_taunt], 
+		strnice(session, " HAHA LOSER!\n", FG_RED, BG_DEFAULT, modheavy, 1),
+		strnice(session, "This game is not for normies.", FG_GREEN, BG_WHITE, modlight, 2),
+		"\n",
+		messages[emj_evil],
+		strnice(session, "  CHOOSE IMPOSSIBLE MODE OR...", FG_RED, BG_WHITE, modheavy, 2)
+	);
+
+	messages[guts] = joinstr(2, 
+		messages[emj_evil],
+		strnice(session, " Yeah!! Now we're talking! Let's Go!", FG_CYAN, BG_DEFAULT, modheavy, 0)
+	);
+
+	messages[true_normie] = joinstr(8,
+		messages[emj_taunt],
+		strnice(session, " It seems that you ", FG_BLUE, BG_DEFAULT, modlight, 0),
+		strnice(session, "really", FG_RED, BG_DEFAULT, modheavy, 2),
+		strnice(session, " want to be a ", FG_BLUE, BG_DEFAULT, modlight, 0),
+		strnice(session, "normie", FG_BRIGHT_BLACK, BG_WHITE, modheavy, 2),
+		strnice(session, " so why would I stop you? ", FG_BLUE, BG_DEFAULT, modlight, 0),
+		messages[emj_taunt],
+		"\n"
+	);
+	
+	// -------------------------------------------------------------------------------- //
+	
+	messages[invalid_choice] = joinstr(7, 
+		messages[emj_sad], 
+		strnice(session, "\nYou chose a wrong input!\n", FG_CYAN, BG_DEFAULT, modheavy, 0),
+		strnice(session, "Please choose again.\n", FG_DEFAULT, BG_DEFAULT, modlight, 1),
+		"\n",
+		messages[emj_evil],
+		strnice(session, "CHOOSE IMPOSSIBLE MODE OR ...", FG_RED, BG_WHITE, modheavy, 2),
+		"\n"
+	);
+
+	messages[invalid_choice_guts] = joinstr(4, 
+		messages[emj_sad], 
+		strnice(session, " You chose a wrong input!\n", FG_CYAN, BG_DEFAULT, modheavy, 0),
+		strnice(session, "Please choose again.\n", FG_DEFAULT, BG_DEFAULT, modlight, 1),
+		"\n"
+	);
+
+	messages[good_choice] = joinstr(2,
+		messages[emj_evil], 
+		strnice(session, " Good Choice", FG_PURPLE, BG_DEFAULT, modheavy, 1)
+	);
+	
+	messages[bad_choice] = joinstr(2, 
+		messages[emj_angry],
+		strnice(session, " You think you're smart huh?", FG_PURPLE, BG_DEFAULT, modheavy, 1)
+	);
+	
+	messages[get_out] = joinstr(3,
+		messages[emj_angry],
+		strnice(session, " I won't be playing with you.\n", FG_PURPLE, BG_DEFAULT, modheavy, 1),
+		strnice(session, "GET OUT!", FG_RED, BG_DEFAULT, modheavy, 2)
+	);
+
+	// -------------------------------------------------------------------------------- //
+
+	messages[dance_msg] = joinstr(3,
+		messages[emj_evil],
+		strnice(session, " HAHA LOSER!! I WON!", FG_PURPLE, BG_DEFAULT, modheavy, 2),
+		"\n"
+	);
+
+	messages[replay] = joinstr(3,
+		strnice(session, "Let's Play Again! ", FG_BLUE, BG_DEFAULT, modheavy, 0),
+		messages[emj_happy],
+		"\n"
+	);
+	
+	messages[true_normie_win] = joinstr(2,
+		messages[emj_smile],
+		strnice(session, " Congrats on your win! You truly deserve it", FG_GREEN, BG_DEFAULT, modlight, 0)
+	);
+
+	messages[true_normie_loss] = joinstr(4,
+		messages[emj_taunt],
+		"\n",
+		messages[emj_evil],
+		strnice(session, "  JUST KIDDING!!!", FG_RED, BG_DEFAULT, modlight, 0)
+	);
+
+	messages[normie_max] = joinstr(2, 
+		strnice(session, "NORMIE", FG_BRIGHT_BLACK, BG_WHITE, modheavy, 2),
+		"     "
+	);
+
+	messages[loading_impossible] = joinstr(1, 
+		strnice(session, "LOADING IMPOSSIBLE MODE", FG_PURPLE, BG_DEFAULT, modheavy, 1));
+	messages[cmp_ichoose] = joinstr(1, strnice(session, "I Choose", FG_CYAN, BG_DEFAULT, modheavy, 0));
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void freemessages(const char* messages[nMSG], const char* dances[nDANCES]) {
+	/*
+		Frees what `buildmessages` built.
+
+		@param const char* messages[nMSG]:		Messages from `buildmessages`.
+		@param const char* dances[nDANCES]:		Dance poses from `buildmessages`.
+	*/
+	for (tiny i = 0; i < nMSG; i++) {
+		free((void*) messages[i]);
+		messages[i] = NULL;
+	}
+
+	// Hardcoded. Will be modified if changed later.
+	free((void*) dances[0]);
+	free((void*) dances[1]);
+	free((void*) dances[4]);
+	free((void*) dances[5]);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void buildtheme(Session* session, THEME theme) {
+	/*
+		Builds the messages that are colored after the player.
+		Built once per color, the first time a player picks it, and kept in `theme_arena`.
+		Replays and repeat games with the same color build nothing.
+
+		@param Session* session:	The game being played.
+		@param THEME theme:	Color chosen by player.
+	*/	
+	FG_COLOR player_color = FG_RED + theme;
+	FG_COLOR computer_color = FG_CYAN;
+	const char** messages = session->themes[theme].messages; // Index by THEMED(MESSAGE_IDX).
+	Arena* arena = &session->theme_arena;
+	size_t allocs_before = arena->total_allocs, bytes_before = arena->total_bytes;
+
+	messages[THEMED(plr_pref_choice)] = arena_joinstr(&session->theme_arena, 4, 
+		"\nDo you want to go first? ", 
+		strnice(session, "\n\t1. YES, I (human) will go first.", 
+			player_color, BG_DEFAULT, modheavy, 1),
+		strnice(session, "\n\t2. NO, You (computer) will go first.", 
+			computer_color, BG_DEFAULT, modheavy, 1),
+		"\n"
+	);
+
+	messages[THEMED(plr_choice_4)] = arena_joinstr(&session->theme_arena, 2,
+		strnice(session, "Now you get to pick certain number of sticks.\n\t", 
+			player_color, BG_DEFAULT, modheavy, 0),
+		strnice(session, "Valid Choices: 1, 2, 3 or 4.\n", 
+			player_color, BG_DEFAULT, modheavy, 1)
+	);
+
+	messages[THEMED(plr_choice_3)] = arena_joinstr(&session->theme_arena, 2,
+		strnice(session, "Now you get to pick certain number of sticks.\n\t", 
+			player_color, BG_DEFAULT, modheavy, 0),
+		strnice(session, "Valid Choices: 1, 2 or 3.\n", 
+			player_color, BG_DEFAULT, modheavy, 1)
+	);
+		
+	messages[THEMED(plr_choice_2)] = arena_joinstr(&session->theme_arena, 2,
+		strnice(session, "Now you get to pick certain number of sticks.\n\t", 
+			player_color, BG_DEFAULT, modheavy, 0),
+		strnice(session, "Valid Choices: 1 or 2.\n", player_color, BG_DEFAULT, modheavy, 1)
+	);
+		
+	messages[THEMED(plr_choice_1)] = arena_joinstr(&session->theme_arena, 2,
+		strnice(session, "Now you get to pick certain number of sticks.\n\t", 
+			player_color, BG_DEFAULT, modheavy, 0),
+		strnice(session, "Valid Choices: ONLY 1.\n", player_color, BG_DEFAULT, modheavy, 1)
+	);
+
+	messages[THEMED(cmp_choice)] = arena_joinstr(&session->theme_arena, 1,
+		strnice(session, "Now it's my turn to choose.\n\t", computer_color, BG_DEFAULT, modheavy, 0)
+	);
+
+	session->themes[theme].built = true;
+	_gc(session); // The strnice pieces are no longer needed.
+
+	// Only `arena_joinstr` allocates from the theme arena. It has no session to count in.
+	metrics_count(session, HELPER_JOINSTR, arena->total_allocs - allocs_before, 
+		arena->total_bytes - bytes_before);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+const char* getmessage(Session* session, THEME theme, MESSAGE_IDX idx) {
+	/*
+		Looks up a message for a player color. Colored messages come from the THEME's
+		set, built on first use. Every other message is the static one.
+
+		@param Session* session:	The game being played.
+		@param THEME theme:			Color chosen by player.
+		@param MESSAGE_IDX idx:		The message.
+		@return const char*:		The message, colored for the theme if needed.
+	*/
+	if (idx < plr_pref_choice || idx > cmp_choice) return MESSAGES[idx];
+	if (!session->themes[theme].built) buildtheme(session, theme);
+	return session->themes[theme].messages[THEMED(idx)];
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                               Subsection: Frame Buffer                               //
+// ------------------------------------------------------------------------------------ //
+/*
+	stdio is not used for the game screens. Drawing appends to the session's `frame`, 
+	and the frame is written with a single `write` when the game is about to wait: 
+	on input (`getn`), on a pause (`pause_frame`) and at the end (`_gc_full_`).
+	On slow links and recorded sessions the syscall count is what costs the most.
+*/
+
+static void fb_reserve(Session* session, size_t extra) {
+	/*
+		Makes room for `extra` more bytes. The buffer doubles when full and is kept.
+
+		@param Session* session:	The game being played.
+		@param size_t extra:	Bytes about to be appended.
+	*/
+	if (session->frame.len + extra <= session->frame.cap) return;
+
+	size_t cap = session->frame.cap ? session->frame.cap * 2 : 4096;
+	while (cap < session->frame.len + extra) cap *= 2;
+	char* buf = realloc(session->frame.buf, cap);
+	if (!buf) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+	session->frame.buf = buf;
+	session->frame.cap = cap;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void fb_write(Session* session, const char* str, size_t len) {
+	/*
+		Appends `len` bytes to the frame.
+
+		@param Session* session:	The game being played.
+		@param const char* str:	Bytes to append.
+		@param size_t len:		How many.
+	*/
+	fb_reserve(session, len);
+	memcpy(session->frame.buf + session->frame.len, str, len);
+	session->frame.len += len;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void fb_print(Session* session, const char* str) {
+	/*
+		Appends a string as is. Replaces `printf(str)`, which would read `%` as format.
+
+		@param Session* session:	The game being played.
+		@param const char* str:	String to append.
+	*/
+	fb_write(session, str, strlen(str));
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void fb_puts(Session* session, const char* str) {
+	/*
+		Appends a string and a newline, like `puts`.
+
+		@param Session* session:	The game being played.
+		@param const char* str:	String to append.
+	*/
+	fb_write(session, str, strlen(str));
+	fb_write(session, "\n", 1);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void fb_putc(Session* session, char c) {
+	/*
+		Appends a single character, like `putchar`.
+
+		@param Session* session:	The game being played.
+		@param char c:	Character to append.
+	*/
+	fb_write(session, &c, 1);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void fb_printf(Session* session, const char* fmt, ...) {
+	/*
+		Formats straight into the frame, like `printf`.
+
+		@param Session* session:	The game being played.
+		@param const char* fmt:	printf format.
+		@vararg:				Format arguments.
+	*/
+	va_list args, again;
+	va_start(args, fmt);
+	va_copy(again, args);
+
+	// Measure first, then format in place. +1 as vsnprintf always writes a NULL.
+	int len = vsnprintf(NULL, 0, fmt, args);
+	if (len > 0) {
+		fb_reserve(session, len + 1);
+		vsnprintf(session->frame.buf + session->frame.len, len + 1, fmt, again);
+		session->frame.len += len;
+	}
+	va_end(again);
+	va_end(args);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+const char* fb_take(Session* session, size_t* len) {
+	/*
+		Hands the pending frame over instead of writing it, for callers that write it 
+		themselves (the server). Goes through the SGR filter first, unless it was turned off.
+
+		@param Session* session:	The game being played.
+		@param size_t* len:		Set to the length of the frame.
+		@return const char*:	The frame. Valid until the next one is drawn.
+	*/
+	const char* data = session->frame.buf;
+	*len = session->frame.len;
+	if (session->sgr.enabled && *len) {
+		*len = sgr_filter(&session->sgr, data, *len);
+		data = session->sgr.out;
+	}
+	session->frame.len = 0;
+	return data;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void fb_flush(Session* session) {
+	/*
+		Writes the pending frame to the terminal. One `write` unless it gets cut short.
+	*/
+	if (!session->frame.len) return;
+
+	size_t len;
+	const char* data = fb_take(session, &len);
+	size_t done = 0, nsyscalls = 0;
+	while (done < len) {
+		#ifdef _WIN32
+			long n = fwrite(data + done, 1, len - done, session->out);
+			fflush(session->out);
+		#else
+			long n = write(session->out_fd, data + done, len - done);
+		#endif
+		nsyscalls++;
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break; // Terminal is gone. Nothing left to show it on.
+		done += n;
+	}
+
+	session->frame.frames++;
+	session->frame.bytes += done;
+	session->frame.syscalls += nsyscalls;
+	session->frame.frame_bytes = done;
+	session->frame.frame_syscalls = nsyscalls;
+
+	// The first frame after a key is the answer to it.
+	Input* input = &session->input;
+	if (input->key_ns) {
+		long long latency = monotonic_ns() - input->key_ns;
+		input->latency_ns += latency;
+		if (latency > input->max_latency_ns) input->max_latency_ns = latency;
+		input->nanswered++;
+		input->key_ns = 0;
+
+		if (session->metrics.enabled) {
+			tiny b = 0;
+			for (long long us = latency / 1000; us && b < METRICS_LATENCY_BUCKETS - 1; us >>= 1) b++;
+			session->metrics.latency[b]++;
+		}
+	}
+
+	#ifdef DEBUG
+		fprintf(stderr, "FRAME %zu: %zu BYTES, %zu SYSCALLS\n", session->frame.frames, done, nsyscalls);
+	#endif
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void pause_frame(Session* session, unsigned ms) {
+	/*
+		Shows the current frame, then waits on the game clock. 
+		In raw mode a key ends the wait, see `Subsection: Input`.
+
+		@param Session* session:	The game being played.
+		@param unsigned ms:		How long to keep the frame on screen, in milliseconds.
+	*/
+	fb_flush(session);
+	Input* input = &session->input;
+	if (input->skip) return; // A key cut the animation short.
+	if (!input->raw || input->eof) return clock_wait(&session->clock, ms);
+	if (clock_wait_fd(&session->clock, ms, session->in_fd)) input_read(session, true);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void tick_frame(Session* session) {
+	/*
+		Shows the current frame for one animation step (`frame_ms` of the clock).
+
+		@param Session* session:	The game being played.
+	*/
+	pause_frame(session, session->clock.frame_ms);
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                Subsection: SGR Filter                                //
+// ------------------------------------------------------------------------------------ //
+/*
+	The messages are styled one piece at a time, and every piece resets when it ends:
+	"\033[32;1m:D\033[0m\033[32m Lets go\033[0m". The terminal only needs to hear 
+	about the style when something is printed with it, and only what differs from the 
+	style it is already in. `sgr_filter` sits between the frame and `write` and does that:
+	SGR sequences only change the style wanted, and the difference is sent right before
+	the next printable byte, either as the changes or as a reset and the whole style,
+	whichever is shorter.
+
+	The screen looks the same with and without it. Erases (J, K...) and newlines fill 
+	with the background, so the style is brought up to date before those too, and at the 
+	end of every frame, as the terminal echoes input in it (see `HIDE`).
+	Styles the filter does not know (256 and RGB colors) are passed through as is until
+	the next reset.
+*/
+
+static bool sgr_same(const SgrState* a, const SgrState* b) {
+	return a->fg == b->fg && a->bg == b->bg && a->mods == b->mods && a->opaque == b->opaque;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static bool sgr_apply(SgrState* state, const char* params, size_t len) {
+	/*
+		Applies the parameters of one SGR sequence to a style. 
+
+		@param SgrState* state:		Style to change.
+		@param const char* params:	Between "\033[" and "m". Empty means 0.
+		@param size_t len:			Length of `params`.
+		@return bool:				false if a code is not one the filter models.
+	*/
+	bool known = true;
+	size_t i = 0;
+	do {
+		int code = 0;
+		tiny ndigits = 0;
+		while (i < len && params[i] >= '0' && params[i] <= '9' && ndigits < 4) {
+			code = code * 10 + params[i++] - '0';
+			ndigits++;
+		}
+		if (i < len && params[i] != ';') { // Sub-parameters, or something else entirely.
+			known = false;
+			while (i < len && params[i] != ';') i++;
+			continue;
+		}
+
+		if (code == RESET) *state = (SgrState) {0};
+		else if (code <= STRIKE) state->mods |= 1 << code;
+		else if (code == 22) state->mods &= ~(1 << BOLD | 1 << FAINT);
+		else if (code == 23 || code == 24 || code == 27 || code == 28 || code == 29)
+			state->mods &= ~(1 << (code - 20));
+		else if (code == 25) state->mods &= ~(1 << BLINK | 1 << RAPID_BLINK);
+		else if ((code >= 30 && code <= 37) || (code >= 90 && code <= 97)) state->fg = code;
+		else if (code == 39) state->fg = 0;
+		else if ((code >= 40 && code <= 47) || (code >= 100 && code <= 107)) state->bg = code;
+		else if (code == 49) state->bg = 0;
+		else known = false; // 38 and 48 take colors as parameters. Those are not followed.
+	} while (i++ < len);
+	return known;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static char* sgr_reserve(SgrFilter* filter, size_t used, size_t extra) {
+	/*
+		Makes room for `extra` more bytes of output. Doubles, like `fb_reserve`.
+
+		@param SgrFilter* filter:	The filter.
+		@param size_t used:		Bytes of output so far.
+		@param size_t extra:	Bytes about to be added.
+		@return char*:			Where they go.
+	*/
+	if (used + extra > filter->cap) {
+		size_t cap = filter->cap ? filter->cap * 2 : 4096;
+		while (cap < used + extra) cap *= 2;
+		char* out = realloc(filter->out, cap);
+		if (!out) {
+			fprintf(stderr, "Out of memory.\n");
+			exit(1);
+		}
+		filter->out = out;
+		filter->cap = cap;
+	}
+	return filter->out + used;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static size_t sgr_sync(SgrFilter* filter, size_t used) {
+	/*
+		Brings the terminal to the wanted style, with the shortest sequence that does.
+
+		@param SgrFilter* filter:	The filter.
+		@param size_t used:			Bytes of output so far.
+		@return size_t:				Bytes of output now.
+	*/
+	const SgrState *term = &filter->term, *want = &filter->want;
+	if (sgr_same(term, want)) return used;
+
+	// A reset, then the whole style.
+	char full[48] = "\033[0;", *end = full + 4;
+	if (want->fg) end = put_code(end, want->fg);
+	if (want->bg) end = put_code(end, want->bg);
+	for (tiny m = BOLD; m <= STRIKE; m++) if (want->mods >> m & 1) end = put_code(end, m);
+	if (end == full + 4) end = full + 2, *end++ = 'm'; // Default style: "\033[m".
+	else end[-1] = 'm';
+	size_t len = end - full;
+	const char* seq = full;
+
+	// Only the changes. Turning off BOLD also turns off FAINT (22), and so on.
+	char diff[48] = "\033[", *at = diff + 2;
+	if (!term->opaque) {
+		uint16_t off = term->mods & ~want->mods, kept = term->mods;
+		if (off & (1 << BOLD | 1 << FAINT)) at = put_code(at, 22), kept &= ~(1 << BOLD | 1 << FAINT);
+		if (off & (1 << BLINK | 1 << RAPID_BLINK))
+			at = put_code(at, 25), kept &= ~(1 << BLINK | 1 << RAPID_BLINK);
+		for (tiny m = ITALIC; m <= STRIKE; m++) {
+			if (off >> m & 1 && m != BLINK && m != RAPID_BLINK) at = put_code(at, 20 + m), kept &= ~(1 << m);
+		}
+		uint16_t on = want->mods & ~kept;
+		for (tiny m = BOLD; m <= STRIKE; m++) if (on >> m & 1) at = put_code(at, m);
+		if (want->fg != term->fg) at = put_code(at, want->fg ? want->fg : 39);
+		if (want->bg != term->bg) at = put_code(at, want->bg ? want->bg : 49);
+		at[-1] = 'm';
+		if (at - diff < (long) len) seq = diff, len = at - diff;
+	}
+
+	memcpy(sgr_reserve(filter, used, len), seq, len);
+	filter->term = filter->want;
+	return used + len;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static size_t sgr_escape(SgrFilter* filter, const char* seq, size_t len, size_t used) {
+	/*
+		Handles one complete escape sequence.
+
+		@param SgrFilter* filter:	The filter.
+		@param const char* seq:		The sequence, from the ESC to the final byte.
+		@param size_t len:			Its length.
+		@param size_t used:			Bytes of output so far.
+		@return size_t:				Bytes of output now.
+	*/
+	char final = seq[len - 1];
+	bool csi = len > 2 && seq[1] == '[';
+
+	if (csi && final == 'm') {
+		SgrState next = filter->want;
+		if (!sgr_apply(&next, seq + 2, len - 3)) next.opaque = true;
+		if (!next.opaque) {
+			filter->want = next; // Sent when something is printed with it.
+			return used;
+		}
+		// Not followed. Pass it on as it is, after what was pending.
+		used = sgr_sync(filter, used);
+		filter->term = filter->want = next;
+	}
+	else if (csi && strchr("JKXLMP@", final)) used = sgr_sync(filter, used); // Erases fill.
+
+	memcpy(sgr_reserve(filter, used, len), seq, len);
+	return used + len;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static size_t sgr_seqlen(const char* seq, size_t len) {
+	/*
+		@param const char* seq:		Starts with ESC.
+		@param size_t len:			Bytes available.
+		@return size_t:				Length of the escape sequence, 0 if it is cut short.
+	*/
+	if (len < 2) return 0;
+	if (seq[1] != '[') return 2;
+	for (size_t i = 2; i < len; i++) if (seq[i] >= 0x40 && seq[i] <= 0x7E) return i + 1;
+	return 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+size_t sgr_filter(SgrFilter* filter, const char* in, size_t len) {
+	/*
+		Filters one frame. The output is in `filter->out` until the next call. 
+		The terminal is left in the style the frame ends with.
+
+		@param SgrFilter* filter:	The filter. Zeroed to start.
+		@param const char* in:		The frame.
+		@param size_t len:			Its length.
+		@return size_t:				Bytes of output.
+	*/
+	size_t used = 0, i = 0;
+	filter->bytes_in += len;
+
+	// The end of the last frame was the start of an escape sequence.
+	if (filter->npartial) {
+		tiny held = filter->npartial;
+		size_t take = len < (size_t) (SGR_PARTIAL_SIZE - held) ? len : SGR_PARTIAL_SIZE - held;
+		memcpy(filter->partial + held, in, take);
+		size_t seqlen = sgr_seqlen(filter->partial, held + take);
+		filter->npartial = 0;
+
+		if (seqlen) {
+			used = sgr_escape(filter, filter->partial, seqlen, used);
+			i = seqlen - held;
+		}
+		else if (held + take < SGR_PARTIAL_SIZE) { // Still not complete. Keep waiting.
+			filter->npartial = held + take;
+			i = len;
+		}
+		else { // Too long to be anything. Let the terminal sort it out.
+			memcpy(sgr_reserve(filter, used, held), filter->partial, held);
+			used += held;
+		}
+	}
+
+	while (i < len) {
+		if (in[i] == 033) {
+			size_t seqlen = sgr_seqlen(in + i, len - i);
+			if (seqlen) {
+				used = sgr_escape(filter, in + i, seqlen, used);
+				i += seqlen;
+				continue;
+			}
+			if (len - i < SGR_PARTIAL_SIZE) {
+				memcpy(filter->partial, in + i, len - i);
+				filter->npartial = len - i;
+				break;
+			}
+			// Unterminated and too long. Copied below like text.
+		}
+
+		// Text, up to the next escape. Anything printed, or a newline that may scroll
+		// the background in, needs the style to be right first.
+		if (!sgr_same(&filter->term, &filter->want)) {
+			unsigned char c = in[i];
+			bool fills = c == '\n' && (filter->term.bg != filter->want.bg || filter->term.opaque);
+			if (c >= 0x20 || fills) used = sgr_sync(filter, used);
+		}
+		const char* esc = memchr(in + i + 1, 033, len - i - 1);
+		size_t run = esc ? (size_t) (esc - in - i) : len - i;
+		if (!sgr_same(&filter->term, &filter->want)) run = 1; // Still controls. Check each.
+		memcpy(sgr_reserve(filter, used, run), in + i, run);
+		used += run;
+		i += run;
+	}
+
+	used = sgr_sync(filter, used);
+	filter->bytes_out += used;
+	return used;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void sgr_filter_free(SgrFilter* filter) {
+	/*
+		Releases the output buffer. The filter keeps its state and totals.
+
+		@param SgrFilter* filter:	The filter.
+	*/
+	free(filter->out);
+	filter->out = NULL;
+	filter->cap = 0;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Clock                                   //
+// ------------------------------------------------------------------------------------ //
+/*
+	All waiting goes through `clock_wait`. The process sleeps until a deadline and uses
+	no CPU meanwhile. In CLK_INSTANT mode nothing sleeps, so a scripted run of the whole
+	game finishes in milliseconds and still draws every frame.
+
+	Chosen with `--clock real|fast|instant` and `--frame MS` (see `clock_args`).
+*/
+
+long long monotonic_ns(void) {
+	/*
+		Time that never jumps back, for deadlines.
+
+		@return long long:	Nanoseconds since some fixed point.
+	*/
+	struct timespec now;
+	#ifdef _WIN32
+		timespec_get(&now, TIME_UTC);
+	#else
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	#endif
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void clock_sync(Clock* vclock) {
+	/*
+		Starts the schedule over from now. Called after blocking on the player, 
+		who may take any amount of time.
+
+		@param Clock* vclock:	Clock of the session.
+	*/
+	if (vclock->mode != CLK_INSTANT) vclock->deadline = monotonic_ns();
+}
+
+// ------------------------------------------------------------------------------------ //
+
+long long clock_deadline(Clock* vclock, unsigned ms) {
+	/*
+		Schedules a wait of `ms` game time, and counts it. Waiting is up to the caller.
+
+		@param Clock* vclock:	Clock of the session.
+		@param unsigned ms:		Game time to wait, in milliseconds.
+		@return long long:		Monotonic ns at which the wait ends. 0 if nothing waits.
+	*/
+	long long wait = ms * 1000000LL;
+	vclock->virtual_ns += wait;
+	vclock->nwaits++;
+	if (vclock->mode == CLK_INSTANT) return 0;
+	if (vclock->mode == CLK_FAST) wait /= CLOCK_FAST_SPEEDUP;
+
+	long long now = monotonic_ns();
+	if (vclock->deadline + wait < now) vclock->deadline = now; // Too far behind. Start over.
+	vclock->deadline += wait;
+	return vclock->deadline;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void clock_wait(Clock* vclock, unsigned ms) {
+	/*
+		Waits `ms` of game time, until `ms` after the previous deadline.
+
+		@param Clock* vclock:	Clock of the session.
+		@param unsigned ms:		Game time to wait, in milliseconds.
+	*/
+	clock_wait_fd(vclock, ms, -1);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool clock_wait_fd(Clock* vclock, unsigned ms, int fd) {
+	/*
+		Same as `clock_wait`, but wakes up as soon as `fd` has something to read.
+		The wait still counts in full as game time. Nothing is read.
+
+		@param Clock* vclock:	Clock of the session.
+		@param unsigned ms:		Game time to wait, in milliseconds.
+		@param int fd:			File to watch, -1 for none. Ignored on Windows.
+		@return bool:			true if woken by `fd`. The schedule then starts over from now.
+	*/
+	if (!clock_deadline(vclock, ms)) return false;
+	long long now = monotonic_ns(), start = now;
+
+	bool woken = false;
+	while (now < vclock->deadline && !woken) {
+		long long left = vclock->deadline - now;
+		#ifdef _WIN32
+			Sleep((left + 999999) / 1000000);
+		#else
+			if (fd >= 0) {
+				struct pollfd watch = {.fd = fd, .events = POLLIN};
+				woken = poll(&watch, 1, (left + 999999) / 1000000) > 0; // Hangups count too.
+			}
+			else {
+				struct timespec rest = {left / 1000000000LL, left % 1000000000LL};
+				nanosleep(&rest, NULL); // Woken early by a signal: the loop sleeps again.
+			}
+		#endif
+		now = monotonic_ns();
+	}
+	if (woken) vclock->deadline = now;
+	vclock->slept_ns += now - start;
+	return woken;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool clock_args(Clock* vclock, int* argc, char* argv[]) {
+	/*
+		Takes the clock options out of the arguments, so the rest can decide 
+		between the game and the headless mode.
+			--clock real|fast|instant		How waits are carried out.
+			--frame MS						Length of one animation step. 1000 by default.
+
+		@param Clock* vclock:	Clock to set up.
+		@param int* argc:		Argument count. Lowered by the options taken.
+		@param char* argv[]:	Arguments. The ones left are moved to the front.
+		@return bool:			false if an option or its value is invalid.
+	*/
+	int kept = 1;
+	for (int a = 1; a < *argc; a++) {
+		const char* arg = argv[a];
+		const char* val = a + 1 < *argc ? argv[a + 1] : NULL;
+
+		if (!strcmp(arg, "--clock") && val) {
+			if (!strcmp(val, "real")) vclock->mode = CLK_REAL;
+			else if (!strcmp(val, "fast")) vclock->mode = CLK_FAST;
+			else if (!strcmp(val, "instant")) vclock->mode = CLK_INSTANT;
+			else return fprintf(stderr, "Invalid clock: %s\n", val), false;
+			a++;
+		}
+		else if (!strcmp(arg, "--frame") && val) {
+			long ms = atol(val);
+			if (ms <= 0 || ms > 60000) return fprintf(stderr, "Invalid frame: %s\n", val), false;
+			vclock->frame_ms = ms;
+			a++;
+		}
+		else argv[kept++] = argv[a];
+	}
+	*argc = kept;
+	argv[kept] = NULL;
+	return true;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Input                                   //
+// ------------------------------------------------------------------------------------ //
+/*
+	With a line-buffered terminal nothing is read until Enter, and nothing is read at all
+	while an animation plays: a key pressed during the dance waits for the whole dance.
+	So on a terminal the session runs it in raw mode (`input_raw`) and waits in `poll` 
+	on the clock's deadline and the terminal together (`clock_wait_fd`):
+		- `getn` takes one key, no Enter needed, and echoes it.
+		- A key pressed during a wait ends the wait, and every wait after it until 
+		  the next prompt: the animation is skipped. The frames are still all drawn.
+		- That key is kept for the next prompt, unless it is Enter or space, which only 
+		  skip. Arrow keys and other escape sequences are dropped.
+	Pipes and files keep the old line-at-a-time reading, so scripted games, recordings
+	and benchmarks play out exactly as before. Not on Windows.
+
+	However the program ends, the terminal is not left in raw mode: `exit` and Ctrl+C, 
+	Ctrl+\ or a kill put it back through a copy of its settings kept here, then go on
+	as they would have.
+*/
+
+#ifndef _WIN32
+	static volatile sig_atomic_t raw_fd = -1;	// The terminal in raw mode, -1 if none.
+	static struct termios raw_saved;			// Its settings before.
+	static const int RAW_SIGNALS[] = {SIGINT, SIGQUIT, SIGTERM};
+	static struct sigaction raw_previous[3];	// Of each of RAW_SIGNALS.
+
+	static void raw_undo(void) {
+		/*
+			Puts the terminal back, if it is still raw. Safe in a signal handler.
+		*/
+		if (raw_fd >= 0) tcsetattr(raw_fd, TCSAFLUSH, &raw_saved);
+		raw_fd = -1;
+	}
+
+	static void raw_on_signal(int sig) {
+		raw_undo();
+		for (tiny i = 0; i < 3; i++) {
+			if (RAW_SIGNALS[i] == sig) sigaction(sig, &raw_previous[i], NULL);
+		}
+		raise(sig); // What it would have done: most likely, end the program.
+	}
+
+	static void raw_hooks(void) {
+		/*
+			Once per program: the exit hook, and a handler for each of RAW_SIGNALS that
+			nothing else handles.
+		*/
+		static bool hooked = false;
+		if (hooked) return;
+		hooked = true;
+		atexit(raw_undo);
+		struct sigaction action = {.sa_handler = raw_on_signal};
+		sigemptyset(&action.sa_mask);
+		for (tiny i = 0; i < 3; i++) {
+			sigaction(RAW_SIGNALS[i], NULL, &raw_previous[i]);
+			if (raw_previous[i].sa_handler == SIG_DFL) sigaction(RAW_SIGNALS[i], &action, NULL);
+		}
+	}
+#endif
+
+// ------------------------------------------------------------------------------------ //
+
+bool input_raw(Session* session) {
+	/*
+		Switches the input to raw mode, if it is a terminal. Signals (Ctrl+C) still work,
+		and put the terminal back before they end the program.
+
+		@param Session* session:	The game being played.
+		@return bool:				Whether the input is now in raw mode.
+	*/
+	#ifdef _WIN32
+		(void) session;
+		return false;
+	#else
+		Input* input = &session->input;
+		int fd = session->in_fd;
+		if (input->raw) return true;
+		if (!isatty(fd) || tcgetattr(fd, &input->saved)) return false;
+
+		struct termios raw = input->saved;
+		raw.c_lflag &= ~(ICANON | ECHO);
+		raw.c_cc[VMIN] = 1; // `read` returns once there is a key. Only called when there is.
+		raw.c_cc[VTIME] = 0;
+		raw_hooks();
+		raw_saved = input->saved;
+		raw_fd = fd; // Before the switch: a signal in between finds it to put back.
+		input->raw = !tcsetattr(fd, TCSANOW, &raw);
+		if (!input->raw) raw_fd = -1;
+		return input->raw;
+	#endif
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void input_restore(Session* session) {
+	/*
+		Puts the terminal back the way `input_raw` found it. Keys never taken are
+		thrown away, not left for the shell.
+
+		@param Session* session:	The game being played.
+	*/
+	#ifndef _WIN32
+		if (!session->input.raw) return;
+		raw_fd = -1;
+		tcsetattr(session->in_fd, TCSAFLUSH, &session->input.saved);
+	#endif
+	session->input.raw = false;
+	session->input.npending = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void input_read(Session* session, bool waiting) {
+	/*
+		Reads the keys the terminal has. Blocks until there is at least one.
+
+		@param Session* session:	The game being played. Input in raw mode.
+		@param bool waiting:		Whether they came during a wait. They skip the animation.
+	*/
+	#ifndef _WIN32
+		Input* input = &session->input;
+		char keys[INPUT_PENDING_SIZE];
+		size_t room = INPUT_PENDING_SIZE - input->npending;
+		if (!room) return; // Typed far ahead. The rest waits in the terminal.
+		long n = read(session->in_fd, keys, room);
+		if (n < 0 && errno == EINTR) return;
+		if (n <= 0) {
+			input->eof = true;
+			return;
+		}
+
+		input->key_ns = monotonic_ns();
+		input->keys++;
+		if (waiting && !input->skip) input->skip = true, input->skips++;
+		if (keys[0] == 033) return; // An escape sequence comes in one read. Not a choice.
+
+		for (long i = 0; i < n; i++) {
+			if (waiting && (keys[i] == '\n' || keys[i] == ' ')) continue; // Only skips.
+			input->pending[input->npending++] = keys[i];
+		}
+	#else
+		(void) session, (void) waiting;
+	#endif
+}
+
+// ------------------------------------------------------------------------------------ //
+
+int input_key(Session* session) {
+	/*
+		The next key, as `getc` would. Waits for one if none was typed ahead.
+
+		@param Session* session:	The game being played. Input in raw mode.
+		@return int:				The key, or EOF once the terminal is gone.
+	*/
+	Input* input = &session->input;
+	while (!input->npending && !input->eof) {
+		input_read(session, false);
+		metrics_poll(session); // The read may have been cut short by a signal asking for them.
+	}
+	if (!input->npending) return EOF;
+
+	char key = input->pending[0];
+	memmove(input->pending, input->pending + 1, --input->npending);
+	return key == 4 ? EOF : (unsigned char) key; // Ctrl+D, as on a line-buffered terminal.
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                 Subsection: Metrics                                  //
+// ------------------------------------------------------------------------------------ //
+/*
+	What a session spent, for whoever runs it: frames, bytes and syscalls written, 
+	arena and helper allocations, time in `computer_pick`, the SGR cache, and how long 
+	each key waited for the frame that answers it. One JSON object per dump, on one line, 
+	so a log of dumps can be read line by line. Counters only go up: diff two dumps for 
+	a rate. `game.bin --metrics FILE` dumps when the game ends and on SIGUSR1.
+*/
+
+void metrics_dump(Session* session, FILE* out) {
+	/*
+		Writes everything counted so far as one line of JSON, and flushes it.
+
+		@param Session* session:	The game being played.
+		@param FILE* out:			Where to write.
+	*/
+	const Metrics* metrics = &session->metrics;
+	const Frame* frame = &session->frame;
+	const Input* input = &session->input;
+	const Arena* arena = &session->frame_arena;
+	const char* names[nHELPERS] = {"itoa", "joinstr", "emojify", "strnice"};
+
+	fprintf(out, "{\"enabled\": %s, \"frames\": %zu, \"bytes_written\": %zu, \"syscalls\": %zu, ",
+		metrics->enabled ? "true" : "false", frame->frames, frame->bytes, frame->syscalls);
+
+	fprintf(out, "\"helpers\": {");
+	for (tiny h = 0; h < nHELPERS; h++) {
+		fprintf(out, "%s\"%s\": {\"allocs\": %zu, \"bytes\": %zu}", h ? ", " : "", names[h], 
+			metrics->allocs[h], metrics->bytes[h]);
+	}
+	fprintf(out, "}, \"frame_arena\": {\"allocs\": %zu, \"bytes\": %zu, \"peak_bytes\": %zu, \"blocks\": %zu}, ",
+		arena->total_allocs, arena->total_bytes, arena->peak_bytes, arena->nblocks);
+
+	// The SGR cache never evicts: its size is its peak.
+	fprintf(out, "\"computer\": {\"picks\": %zu, \"ns\": %lld, \"max_ns\": %lld}, "
+		"\"sgr\": {\"cache_peak\": %d, \"bytes_in\": %zu, \"bytes_out\": %zu}, ",
+		metrics->computer_picks, metrics->computer_ns, metrics->computer_max_ns,
+		session->nsgr_cache, session->sgr.bytes_in, session->sgr.bytes_out);
+
+	fprintf(out, "\"input\": {\"keys\": %zu, \"skips\": %zu, \"answered\": %zu, "
+		"\"latency_ns\": %lld, \"max_latency_ns\": %lld, \"latency_us\": {\"bounds\": [",
+		input->keys, input->skips, input->nanswered, input->latency_ns, input->max_latency_ns);
+	for (tiny b = 0; b < METRICS_LATENCY_BUCKETS - 1; b++) fprintf(out, "%s%ld", b ? ", " : "", 1L << b);
+	fprintf(out, "], \"counts\": [");
+	for (tiny b = 0; b < METRICS_LATENCY_BUCKETS; b++) fprintf(out, "%s%zu", b ? ", " : "", metrics->latency[b]);
+	fprintf(out, "]}}}\n");
+	fflush(out);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void metrics_poll(Session* session) {
+	/*
+		Dumps the metrics to `out` if `dump` was set, and clears it. Called between steps,
+		and after reads a signal may have cut short, so a player idle at a prompt does not
+		hold up a dump.
+
+		@param Session* session:	The game being played.
+	*/
+	if (!session->metrics.dump) return;
+	session->metrics.dump = 0;
+	if (session->metrics.out) metrics_dump(session, session->metrics.out);
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                               Subsection: Terminal I/O                               //
+// ------------------------------------------------------------------------------------ //
+
+static int input_getc(Session* session) {
+	/*
+		`getc` of the input, carried on across signals. Without SA_RESTART, a signal
+		ends `getc` with an error, which is not the end of the input.
+
+		@param Session* session:	The game being played.
+		@return int:				The character, or EOF.
+	*/
+	int c;
+	while ((c = getc(session->in)) == EOF && ferror(session->in) && errno == EINTR) {
+		clearerr(session->in);
+		metrics_poll(session);
+	}
+	return c;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny getn(Session* session) {
+	/*
+		Reads the first character from stdin and returns it as a tiny.
+		In raw mode that is the next key, echoed with a newline as the terminal would.
+
+		@return tiny:	Numeric face value of character entered.
+	*/ 
+	fb_flush(session); // Show the prompt before blocking.
+	int n;
+	if (session->input.raw) {
+		n = input_key(session);
+		if (n != EOF && n != '\n') fb_putc(session, n);
+		if (n != EOF) fb_putc(session, '\n');
+	}
+	else {
+		int _;
+		n = input_getc(session);
+		if (n != '\n' && n != EOF) while ((_ = input_getc(session)) != '\n' && _ != EOF); // FLUSH input
+		session->input.key_ns = monotonic_ns();
+		if (n == EOF) session->input.eof = true;
+	}
+	session->input.skip = false; // Waits after a prompt are shown in full again.
+	clock_sync(&session->clock); // The player took their time. Animations start over from now.
+	if (n == '\n' || n == EOF) return -1;
+	return n - '0';
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void cls(Session* session){
+	/*
+		Clears the ANSI terminal, using escape sequences.
+		These are the codes decided by ANSI.
+			2J -> CLS;
+			H -> RESET cursor to HOME;
+	*/
+	#ifndef DEBUG
+		fb_print(session, "\033[2J\033[H");
+	#endif
+	session->screen.valid = false; // Nothing left to draw over. See `draw_board`.
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static const char* stick_segment(Session* session, PLAYER owner, tiny len, FG_COLOR color) {
+	/*
+		A pick drawn as sticks: `len` bars in the owner's color. Short ones are colored
+		once and kept in the session's `Segments`, longer ones go to the frame arena.
+
+		@param Session* session:	The game being played.
+		@param PLAYER owner:		Who picked. Computer uses \\, Player /.
+		@param tiny len:			Sticks picked.
+		@param FG_COLOR color:		Color of the owner.
+		@return const char*:		The colored sticks.
+	*/
+	Segments* kept = &session->segments;
+	char bars[BOARD_MAX_POOL + 1];
+	memset(bars, owner == COMPUTER ? '\\' : '/', len);
+	bars[(unsigned char) len] = 0; // NULL terminator.
+
+	session->screen.colors[owner] = color;
+	if (kept->colors[owner] != color) { // New color. The kept segments are stale.
+		kept->colors[owner] = color;
+		for (tiny i = 0; i < SCREEN_SEGMENTS; i++) kept->segments[owner][i][0] = 0;
+	}
+	if (len >= SCREEN_SEGMENTS) return strnice(session, bars, color, BG_DEFAULT, modheavy, 0);
+
+	char* segment = kept->segments[owner][(unsigned char) len];
+	if (!*segment && strnice_into(session, segment, SCREEN_SEGMENT_SIZE, bars, color, BG_DEFAULT, 
+			modheavy, 0) >= SCREEN_SEGMENT_SIZE) {
+		return strnice(session, bars, color, BG_DEFAULT, modheavy, 0); // Does not fit.
+	}
+	return segment;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void printsticks(Session* session, Board board, tiny pool, 
+		FG_COLOR player_color, FG_COLOR computer_color) {
+	/*
+		Used to print the sticks selected & remaining.
+		Colors them as necessary.
+	
+		@param Session* session:		The game being played.
+		@param Board board:				The game so far. Each pick is drawn in its color.
+		@param tiny pool:				Sticks at the start.
+		@param FG_COLOR player_color:	Color that describes the player.
+		@param FG_COLOR computer_color:	Color that describes the computer.
+	*/
+	FG_COLOR colors[2] = {player_color, computer_color};
+	tiny taken = board_taken(board), start = 0, stick;
+
+	// A pick is a run of sticks with the same owner. Computer uses \\, Player /, Unused |
+	for (stick = 1; stick <= taken; stick++) {
+		PLAYER owner = board_owner(board, start);
+		if (stick < taken && board_owner(board, stick) == owner) continue;
+
+		fb_print(session, stick_segment(session, owner, stick - start, colors[owner]));
+		start = stick; // Next pick.
+	}
+
+	// Unused bars.
+	char* bars = arena_alloc(&session->frame_arena, pool - taken + 1);
+	memset(bars, '|', pool - taken);
+	bars[pool - taken] = 0; // NULL Terminator.
+	fb_puts(session, bars);
+	_gc(session);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void draw_board(Session* session, Board board, tiny pool, 
+		FG_COLOR player_color, FG_COLOR computer_color) {
+	/*
+		Draws the board line at the top of the screen, and clears the screen under it.
+		If the screen still shows an earlier position of the same game, only the sticks
+		taken since and the counter are drawn, at their place (cursor addressing). 
+		Otherwise the screen is cleared and the line drawn in full.
+		Either way the cursor ends at the start of the second line.
+
+		@param Session* session:		The game being played.
+		@param Board board:				The game so far.
+		@param tiny pool:				Sticks at the start.
+		@param FG_COLOR player_color:	Color that describes the player.
+		@param FG_COLOR computer_color:	Color that describes the computer.
+	*/
+	Screen* screen = &session->screen;
+	tiny taken = board_taken(board), shown = board_taken(screen->board);
+	size_t before = session->frame.bytes + session->frame.len;
+	char digits[24];
+	int ndigits = snprintf(digits, sizeof(digits), "%d", pool);
+
+	bool delta = screen->valid && screen->pool == pool && shown <= taken
+		&& !((board ^ screen->board) & ((1ULL << shown) - 1)) // Same picks so far.
+		&& screen->colors[HUMAN] == player_color && screen->colors[COMPUTER] == computer_color;
+
+	if (delta) {
+		FG_COLOR colors[2] = {player_color, computer_color};
+		fb_printf(session, "\033[1;%dH%-*d", screen->counter_col, ndigits, pool - taken);
+
+		// The new picks, over the unused bars. They follow each other: one move is enough.
+		int gap = screen->sticks_col + shown - screen->counter_col - ndigits;
+		if (shown < taken) fb_printf(session, "\033[%dC", gap);
+		for (tiny start = shown, stick = shown + 1; stick <= taken; stick++) {
+			PLAYER owner = board_owner(board, start);
+			if (stick < taken && board_owner(board, stick) == owner) continue;
+			fb_print(session, stick_segment(session, owner, stick - start, colors[owner]));
+			start = stick;
+		}
+		fb_print(session, "\n\033[J"); // Same as the full line's newline, then clear the rest.
+		screen->delta_draws++;
+	} else {
+		cls(session);
+		#ifdef DEBUG 
+			fb_printf(session, "Sticks Collected: %d\t", taken);
+		#endif
+		fb_printf(session, "Sticks Remaining: %d\t\t\t\tSticks:\t", pool - taken);
+		printsticks(session, board, pool, player_color, computer_color);
+
+		// Where the tabs put things, with the usual stops every 8 columns.
+		int col = strlen("Sticks Remaining: ") + snprintf(digits, sizeof(digits), "%d", pool - taken);
+		for (tiny tab = 0; tab < 4; tab++) col = (col / 8 + 1) * 8;
+		col = ((col + strlen("Sticks:")) / 8 + 1) * 8;
+		screen->counter_col = strlen("Sticks Remaining: ") + 1;
+		screen->sticks_col = col + 1;
+		screen->full_draws++;
+
+		#ifdef DEBUG
+			screen->valid = false; // No `cls` in DEBUG. The board scrolls, so always in full.
+		#else
+			screen->valid = true;
+		#endif
+	}
+
+	screen->board = board;
+	screen->pool = pool;
+	screen->bytes += session->frame.bytes + session->frame.len - before;
+}
+
+// ------------------------------------------------------------------------------------ //
+// ------------------------------------------------------------------------------------ //
+
+
+
+// ==================================================================================== //
+//                          Function Implementations - Primary                          //
+// ==================================================================================== //
+
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Random                                  //
+// ------------------------------------------------------------------------------------ //
+/*
+	`rand` has one hidden state for the whole process. Anything that plays many games,
+	or plays on several threads, keeps an `Rng` of its own instead.
+*/
+
+void rng_seed(Rng* rng, uint64_t seed) {
+	/*
+		Seeds the generator. The seed is spread over the state with splitmix64, 
+		so close seeds (0, 1, 2...) still give unrelated streams.
+
+		@param Rng* rng:		Generator to seed.
+		@param uint64_t seed:	Any number.
+	*/
+	for (tiny i = 0; i < 4; i++) {
+		uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		rng->s[i] = z ^ (z >> 31);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+uint64_t rng_next(Rng* rng) {
+	/*
+		@param Rng* rng:	A seeded generator.
+		@return uint64_t:	The next random number. All 64 bits are usable.
+	*/
+	uint64_t* s = rng->s;
+	uint64_t x = s[1] * 5, result = (x << 7 | x >> 57) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = s[3] << 45 | s[3] >> 19;
+	return result;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Board                                   //
+// ------------------------------------------------------------------------------------ //
+/*
+	The game in progress, packed in a `Board`:
+		bits 0-55:	Owner of each stick taken, in the order taken. 1 for the computer.
+		bits 56-61:	How many sticks were taken.
+		bit 63:		Set when the computer is to move.
+	
+	Players alternate, so a pick is a run of sticks with the same owner. Nothing else
+	has to be stored to draw the game, replay it or take back the last pick.
+*/
+
+static inline int highest_bit(uint64_t bits) {
+	/*
+		Index of the highest set bit. `bits` must not be 0.
+	*/
+	#ifdef __GNUC__
+		return 63 - __builtin_clzll(bits);
+	#else
+		int i = 0;
+		while (bits >>= 1) i++;
+		return i;
+	#endif
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static inline int count_bits(uint64_t bits) {
+	/*
+		Number of set bits.
+	*/
+	#ifdef __GNUC__
+		return __builtin_popcountll(bits);
+	#else
+		int count = 0;
+		for (; bits; bits &= bits - 1) count++;
+		return count;
+	#endif
+}
+
+// ------------------------------------------------------------------------------------ //
+
+Board board_new(PLAYER first) {
+	/*
+		@param PLAYER first:	Who picks first.
+		@return Board:			A game with no stick taken yet.
+	*/
+	return first == COMPUTER ? BOARD_TURN : 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+Board board_apply(Board board, tiny pick) {
+	/*
+		@param Board board:		A game with at least `pick` sticks to go, within BOARD_MAX_POOL.
+		@param tiny pick:		Sticks the player to move takes. At least 1.
+		@return Board:			The game after the pick, with the other player to move.
+	*/
+	tiny taken = board_taken(board);
+	if (board & BOARD_TURN) board |= ((1ULL << pick) - 1) << taken; // Computer's sticks.
+	return (board + ((uint64_t) pick << BOARD_TAKEN_SHIFT)) ^ BOARD_TURN;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+Board board_undo(Board board) {
+	/*
+		Takes back the last pick. The run of same-owner sticks at the top of the history
+		is found with one bit scan, so this is O(1) like `board_apply`.
+
+		@param Board board:		A game.
+		@return Board:			The game before its last pick. Unchanged if there was none.
+	*/
+	tiny taken = board_taken(board), last = board_last(board);
+	if (!taken) return board;
+
+	uint64_t kept = (1ULL << (taken - last)) - 1;
+	return ((board & kept) | ((uint64_t) (taken - last) << BOARD_TAKEN_SHIFT)
+		| (board & BOARD_TURN)) ^ BOARD_TURN;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny board_taken(Board board) {
+	/*
+		@param Board board:		A game.
+		@return tiny:			Sticks taken so far, by both players.
+	*/
+	return board >> BOARD_TAKEN_SHIFT & 0x3F;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+PLAYER board_turn(Board board) {
+	/*
+		@param Board board:		A game.
+		@return PLAYER:			Who is to move.
+	*/
+	return board & BOARD_TURN ? COMPUTER : HUMAN;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+PLAYER board_owner(Board board, tiny stick) {
+	/*
+		@param Board board:		A game.
+		@param tiny stick:		A stick already taken, 0 for the first.
+		@return PLAYER:			Who took it.
+	*/
+	return board >> stick & 1 ? COMPUTER : HUMAN;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny board_last(Board board) {
+	/*
+		@param Board board:		A game.
+		@return tiny:			Size of the last pick, 0 if nothing was picked yet.
+	*/
+	tiny taken = board_taken(board);
+	if (!taken) return 0;
+
+	// Sticks of the player not to move come out as 1s. The last pick is the top run.
+	uint64_t mask = (1ULL << taken) - 1;
+	uint64_t others = (board & BOARD_TURN ? ~board : board) & mask;
+	return others == mask ? taken : taken - 1 - highest_bit(~others & mask);
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Replay                                  //
+// ------------------------------------------------------------------------------------ //
+/*
+	Replay logs. Games are appended as they end, and read back memory-mapped.
+	All numbers are little endian.
+
+	File header, REPLAY_HEADER_SIZE bytes:
+		0	magic		REPLAY_MAGIC, 4 bytes.
+		4	version		REPLAY_VERSION, 1 byte.
+		5	misere		1 byte, 0 or 1.
+		6	(zero)		2 bytes.
+		8	pool		8 bytes.
+		16	moves		8 bytes. Bit s-1 set means s may be picked, as in `Rules`.
+
+	Then one record per game:
+		flags			1 byte. Bits 0-2: theme. 3: computer first. 4: refused.
+						5: normie. 6: seed stored. 7: computer won.
+		npicks			Varint: 7 bits per byte, low first, high bit set if more follow.
+		seed			8 bytes, only if flag 6 is set.
+		picks			npicks * bits, packed from the low bit up, padded to a byte.
+						Each is the index of the pick among the allowed picks, smallest 0.
+
+	The bits per pick come from the rules: enough to number the allowed picks, 2 for 1-4.
+	A classic game takes 4 to 9 bytes, 12 to 17 with its seed.
+*/
+
+#define REPLAY_FIRST_COMPUTER 0x08
+#define REPLAY_REFUSED 0x10
+#define REPLAY_NORMIE 0x20
+#define REPLAY_SEEDED 0x40
+#define REPLAY_COMPUTER_WON 0x80
+
+static void put_le(uint8_t* at, uint64_t value, tiny nbytes) {
+	/*
+		@param uint8_t* at:		Where to write.
+		@param uint64_t value:	Number to write.
+		@param tiny nbytes:		How many of its low bytes.
+	*/
+	for (tiny i = 0; i < nbytes; i++) at[i] = value >> (8 * i);
+}
+
+static uint64_t get_le(const uint8_t* at, tiny nbytes) {
+	/*
+		@param const uint8_t* at:	Where to read.
+		@param tiny nbytes:			How many bytes.
+		@return uint64_t:			The number.
+	*/
+	uint64_t value = 0;
+	for (tiny i = 0; i < nbytes; i++) value |= (uint64_t) at[i] << (8 * i);
+	return value;
+}
+
+static tiny pick_bits(uint64_t moves) {
+	/*
+		@param uint64_t moves:	Allowed picks.
+		@return tiny:			Bits needed to number them. 0 if there is only one.
+	*/
+	tiny count = 0, bits = 0;
+	for (; moves; moves &= moves - 1) count++;
+	while ((1 << bits) < count) bits++;
+	return bits;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool replay_open(ReplayLog* log, const char* path, const Rules* rules) {
+	/*
+		Opens a replay log for appending. Creates it if it does not exist.
+
+		@param ReplayLog* log:			Log to open.
+		@param const char* path:		The file.
+		@param const Rules* rules:		Rules of the games to come. An existing file must 
+										have been written with the same.
+		@return bool:					false if the file could not be opened, is not a 
+										replay log, or holds other rules.
+	*/
+	*log = (ReplayLog) {.rules = *rules, .bits = pick_bits(rules->moves)};
+	log->file = fopen(path, "ab+");
+	if (!log->file) return false;
+
+	uint8_t header[REPLAY_HEADER_SIZE] = {0};
+	memcpy(header, REPLAY_MAGIC, 4);
+	header[4] = REPLAY_VERSION;
+	header[5] = rules->misere;
+	put_le(header + 8, rules->pool, 8);
+	put_le(header + 16, rules->moves, 8);
+
+	// "a" mode writes at the end whatever the position, but reads from it.
+	fseek(log->file, 0, SEEK_END);
+	if (ftell(log->file) == 0) {
+		if (fwrite(header, 1, sizeof(header), log->file) == sizeof(header)) return true;
+	} else {
+		uint8_t existing[REPLAY_HEADER_SIZE];
+		rewind(log->file);
+		// A write may not follow a read without a seek in between.
+		if (fread(existing, 1, sizeof(existing), log->file) == sizeof(existing)
+				&& !memcmp(existing, header, sizeof(header)) && !fseek(log->file, 0, SEEK_END)) 
+			return true;
+	}
+	fclose(log->file);
+	log->file = NULL;
+	return false;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void replay_push(ReplayLog* log, tiny pick) {
+	/*
+		Adds a pick to the game being recorded.
+
+		@param ReplayLog* log:	An open log.
+		@param tiny pick:		An allowed pick. Players alternate, so whose it is is implied.
+	*/
+	size_t bit = log->npicks++ * log->bits;
+	if ((bit + log->bits + 7) / 8 > log->cap) {
+		size_t cap = log->cap ? log->cap * 2 : 64;
+		uint8_t* picks = realloc(log->picks, cap);
+		if (!picks) {
+			fprintf(stderr, "Out of memory.\n");
+			exit(1);
+		}
+		memset(picks + log->cap, 0, cap - log->cap);
+		log->picks = picks;
+		log->cap = cap;
+	}
+
+	// Index of the pick among the allowed ones.
+	unsigned index = 0;
+	for (uint64_t below = log->rules.moves & ((1ULL << (pick - 1)) - 1); below; below &= below - 1) 
+		index++;
+	for (tiny b = 0; b < log->bits; b++, bit++) {
+		if (index >> b & 1) log->picks[bit / 8] |= 1 << (bit % 8);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool replay_end(ReplayLog* log, const ReplayGame* game) {
+	/*
+		Appends the game with the picks pushed since the last one.
+		Once a write fails, nothing more is appended: the games after a cut one would be 
+		read wrong.
+
+		@param ReplayLog* log:				An open log.
+		@param const ReplayGame* game:		The rest of the game. Its `npicks` is ignored.
+		@return bool:						false if the game could not be written.
+	*/
+	uint8_t head[1 + 10 + 8];
+	size_t len = 1, nbytes = (log->npicks * log->bits + 7) / 8;
+
+	head[0] = (game->theme & 0b111) | (game->first == COMPUTER ? REPLAY_FIRST_COMPUTER : 0)
+		| (game->refused ? REPLAY_REFUSED : 0) | (game->normie ? REPLAY_NORMIE : 0)
+		| (game->seeded ? REPLAY_SEEDED : 0) | (game->winner == COMPUTER ? REPLAY_COMPUTER_WON : 0);
+	for (uint64_t n = log->npicks; ; n >>= 7) {
+		head[len++] = (n & 0x7F) | (n >= 0x80 ? 0x80 : 0);
+		if (n < 0x80) break;
+	}
+	if (game->seeded) put_le(head + len, game->seed, 8), len += 8;
+
+	if (!log->failed) log->failed = fwrite(head, 1, len, log->file) != len 
+		|| (nbytes && fwrite(log->picks, 1, nbytes, log->file) != nbytes);
+	memset(log->picks, 0, nbytes);
+	log->npicks = 0;
+	if (log->failed) return false;
+	log->ngames++;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool replay_close(ReplayLog* log) {
+	/*
+		@param ReplayLog* log:	Log to close. A game being recorded is dropped.
+		@return bool:			false if any game could not be written.
+	*/
+	bool ok = !log->failed;
+	if (log->file && fclose(log->file)) ok = false; // Flushes what is left.
+	free(log->picks);
+	*log = (ReplayLog) {0};
+	return ok;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool replay_map(ReplayReader* reader, const char* path) {
+	/*
+		Maps a replay log into memory. Nothing is read until the records are walked.
+
+		@param ReplayReader* reader:	Reader to open.
+		@param const char* path:		The file.
+		@return bool:					false if the file cannot be read, or is not a 
+										replay log.
+	*/
+	*reader = (ReplayReader) {.pos = REPLAY_HEADER_SIZE};
+
+	#ifdef _WIN32
+		FILE* file = fopen(path, "rb");
+		if (!file) return false;
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		uint8_t* data = size > 0 ? malloc(size) : NULL;
+		rewind(file);
+		if (data && fread(data, 1, size, file) == (size_t) size) {
+			reader->data = data;
+			reader->size = size;
+		} else free(data);
+		fclose(file);
+	#else
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) return false;
+		struct stat info;
+		if (!fstat(fd, &info) && info.st_size > 0) {
+			void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+				madvise(data, info.st_size, MADV_SEQUENTIAL); // Read ahead hard.
+				reader->data = data;
+				reader->size = info.st_size;
+				reader->mapped = true;
+			}
+		}
+		close(fd); // The mapping stays.
+	#endif
+
+	const uint8_t* header = reader->data;
+	if (reader->size < REPLAY_HEADER_SIZE || memcmp(header, REPLAY_MAGIC, 4)
+			|| header[4] != REPLAY_VERSION) {
+		replay_unmap(reader);
+		return false;
+	}
+
+	reader->rules = (Rules) {
+		.pool = get_le(header + 8, 8),
+		.moves = get_le(header + 16, 8),
+		.misere = header[5]
+	};
+	reader->bits = pick_bits(reader->rules.moves);
+	for (tiny s = 1; s <= 64; s++) 
+		if (reader->rules.moves >> (s - 1) & 1) reader->picks[reader->npicks++] = s;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool replay_next(ReplayReader* reader, ReplayGame* game, const uint8_t** picks) {
+	/*
+		Reads the next record. Only its header is decoded; the picks are skipped over,
+		so walking a log runs at memory speed. The winner is in the header for the same 
+		reason.
+
+		@param ReplayReader* reader:	A mapped log.
+		@param ReplayGame* game:		Where the record goes.
+		@param const uint8_t** picks:	Set to the packed picks. See `replay_pick`.
+		@return bool:					false at the end of the log. A record cut short 
+										(by a crash while appending) ends it too, as does
+										one with more picks than the pool has sticks.
+	*/
+	const uint8_t *at = reader->data + reader->pos, *end = reader->data + reader->size;
+	if (at >= end) return false;
+
+	uint8_t flags = *at++;
+	uint64_t npicks = 0;
+	for (tiny shift = 0; ; shift += 7) {
+		if (at >= end || shift > 63) return false;
+		npicks |= (uint64_t) (*at & 0x7F) << shift;
+		if (!(*at++ & 0x80)) break;
+	}
+
+	*game = (ReplayGame) {
+		.theme = flags & 0b111,
+		.first = flags & REPLAY_FIRST_COMPUTER ? COMPUTER : HUMAN,
+		.winner = flags & REPLAY_COMPUTER_WON ? COMPUTER : HUMAN,
+		.refused = flags & REPLAY_REFUSED,
+		.normie = flags & REPLAY_NORMIE,
+		.seeded = flags & REPLAY_SEEDED,
+		.npicks = npicks
+	};
+	if (game->seeded) {
+		if (end - at < 8) return false;
+		game->seed = get_le(at, 8);
+		at += 8;
+	}
+
+	// Every pick takes a stick. Checked before the size, which could wrap past it.
+	if (npicks > (uint64_t) reader->rules.pool) return false;
+	if (reader->bits && npicks > (uint64_t) (end - at) * 8 / reader->bits) return false;
+	uint64_t nbytes = (npicks * reader->bits + 7) / 8;
+	*picks = at;
+	reader->pos = at + nbytes - reader->data;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny replay_pick(const ReplayReader* reader, const uint8_t* picks, long long n) {
+	/*
+		@param const ReplayReader* reader:	The log the picks are from.
+		@param const uint8_t* picks:		Picks of a game, from `replay_next`.
+		@param long long n:					Which one. 0 is the first, up to `npicks` - 1.
+		@return tiny:						The pick. 0 if the number stored stands for none: 
+											the record is corrupt.
+	*/
+	uint64_t bit = n * reader->bits;
+	unsigned index = 0;
+	for (tiny b = 0; b < reader->bits; b++, bit++) index |= (picks[bit / 8] >> (bit % 8) & 1) << b;
+	return index < reader->npicks ? reader->picks[index] : 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void replay_unmap(ReplayReader* reader) {
+	/*
+		@param ReplayReader* reader:	Reader to close. Its games' picks become invalid.
+	*/
+	#ifdef _WIN32
+		free((void*) reader->data);
+	#else
+		if (reader->mapped) munmap((void*) reader->data, reader->size);
+	#endif
+	*reader = (ReplayReader) {0};
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void replay_show(Session* session, const ReplayReader* reader, const ReplayGame* game, 
+		const uint8_t* picks) {
+	/*
+		Plays a recorded game back, one pick per frame, drawn by `draw_board`.
+
+		@param Session* session:			Where to draw it. Only the clock and the output
+											are used.
+		@param const ReplayReader* reader:	The log. Its pool must be BOARD_MAX_POOL at most.
+		@param const ReplayGame* game:		The game.
+		@param const uint8_t* picks:		Its picks.
+	*/
+	tiny pool = reader->rules.pool;
+	Board board = board_new(game->first);
+	FG_COLOR player_color = game->theme < nTHEMES ? FG_RED + game->theme : FG_GREEN;
+	FG_COLOR computer_color = FG_CYAN;
+	const char* names[2] = {"You", "I"};
+
+	for (long long n = 0; ; n++) {
+		draw_board(session, board, pool, player_color, computer_color);
+		fb_puts(session, "");
+		if (n == game->npicks) break;
+
+		tiny pick = replay_pick(reader, picks, n);
+		if (!pick || pick > pool - board_taken(board)) { // Not a game of these rules.
+			fb_puts(session, "The rest of the record is corrupt.");
+			pause_frame(session, 2000);
+			return;
+		}
+		fb_printf(session, "%s picked %d.\n", names[board_turn(board)], pick);
+		board = board_apply(board, pick);
+		pause_frame(session, 1000);
+	}
+
+	if (game->refused) fb_puts(session, "I REFUSEd to pick the last stick.");
+	fb_puts(session, game->winner == COMPUTER ? "I won." : "You won.");
+	pause_frame(session, 2000);
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Solver                                  //
+// ------------------------------------------------------------------------------------ //
+/*
+	Any subtraction game: a pool of sticks, a set of allowed picks, and whether picking 
+	the last stick wins (normal play) or loses (misere play, like this game).
+
+	Position n (sticks remaining) is losing for the player to move if every legal pick 
+	leads to a winning position. The table is built bottom up. A 64-bit window holds 
+	the results of the last 64 positions, so all picks are checked with a single AND.
+	A player with no legal pick at all loses in normal play and wins in misere play.
+*/
+
+uint64_t legal_moves(const Rules* rules, long long remaining) {
+	/*
+		@param const Rules* rules:		Rules of the game.
+		@param long long remaining:		Sticks left in the pool.
+		@return uint64_t:				Allowed picks that fit in the pool. Bit s-1 for s.
+	*/
+	if (remaining <= 0) return 0;
+	if (remaining >= 64) return rules->moves;
+	return rules->moves & ((1ULL << remaining) - 1);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny random_move(const Rules* rules, long long remaining, uint64_t r) {
+	/*
+		A random legal pick. Every legal pick is equally likely.
+		The randomness comes from the caller, so each caller keeps its own generator.
+
+		@param const Rules* rules:		Rules of the game.
+		@param long long remaining:		Sticks left in the pool.
+		@param uint64_t r:				A random number.
+		@return tiny:					The pick, 0 if there is no legal pick.
+	*/
+	uint64_t legal = legal_moves(rules, remaining);
+	if (!legal) return 0;
+
+	int count = count_bits(legal);
+
+	// Drop the lowest set bits until the chosen one is the lowest.
+	for (int k = r % count; k--;) legal &= legal - 1;
+	return highest_bit(legal & -legal) + 1;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool forced_last(const Rules* rules, long long remaining) {
+	/*
+		Whether the only legal pick takes the last stick, losing a misere game.
+		This is when the computer REFUSEs to go on.
+
+		@param const Rules* rules:		Rules of the game.
+		@param long long remaining:		Sticks left in the pool.
+		@return bool:					Whether the player to move is about to lose.
+	*/
+	return rules->misere && remaining > 0 && remaining <= 64 
+		&& legal_moves(rules, remaining) == 1ULL << (remaining - 1);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void solver_build(Solver* solver, Rules rules, long long nbits) {
+	/*
+		Fills the table for positions 0 to nbits-1. The brute force DP.
+
+		@param Solver* solver:	Solver to build.
+		@param Rules rules:		Rules of the game to solve.
+		@param long long nbits:	Number of positions to store.
+	*/
+	solver->rules = rules;
+	solver->nbits = nbits;
+	solver->nwords = (nbits + 63) / 64;
+	solver->losing = calloc(solver->nwords, sizeof(uint64_t));
+	if (!solver->losing) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+
+	solver->revmoves = 0;
+	for (tiny s = 1; s <= 64; s++) 
+		if (rules.moves >> (s - 1) & 1) solver->revmoves |= 1ULL << (64 - s);
+
+	// Bit i of window: whether position n-1-i is losing.
+	uint64_t window = 0;
+	for (long long n = 0; n < nbits; n++) {
+		uint64_t legal = legal_moves(&rules, n);
+		bool lose = legal ? !(window & legal) : !rules.misere;
+
+		window = window << 1 | lose;
+		solver->losing[n >> 6] |= (uint64_t) lose << (n & 63);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void solver_init(Solver* solver, Rules rules) {
+	/*
+		Solves the game for every pool size from 0 to `rules.pool`.
+		Done once at startup. Afterwards every lookup is O(1).
+		Only the preperiod and one period are stored, however large the pool is.
+
+		@param Solver* solver:	Solver to build.
+		@param Rules rules:		Rules of the game to solve.
+	*/
+	tiny maxmove = highest_bit(rules.moves) + 1;
+	uint64_t mask = maxmove == 64 ? ~0ULL : (1ULL << maxmove) - 1;
+
+	// Positions below the largest pick have fewer legal picks. Play through them.
+	uint64_t window = 0;
+	for (long long n = 0; n < maxmove; n++) {
+		uint64_t legal = legal_moves(&rules, n);
+		window = window << 1 | (legal ? !(window & legal) : !rules.misere);
+	}
+	window &= mask;
+
+	// From here on, every pick is legal and the next window depends only on this one.
+	#define NEXT(w) (((w) << 1 | !((w) & rules.moves)) & mask)
+
+	// Brent: find the period by moving the tortoise to the hare at every power of two.
+	long long power = 1, period = 1, start = 0;
+	uint64_t tortoise = window, hare = NEXT(window);
+	while (tortoise != hare && period <= SOLVER_MAX_PERIOD) {
+		if (power == period) {
+			tortoise = hare;
+			power *= 2;
+			period = 0;
+		}
+		hare = NEXT(hare);
+		period++;
+	}
+
+	// Then the preperiod: walk two windows `period` apart until they meet.
+	if (period <= SOLVER_MAX_PERIOD) {
+		tortoise = hare = window;
+		for (long long i = 0; i < period; i++) hare = NEXT(hare);
+		while (tortoise != hare) {
+			tortoise = NEXT(tortoise);
+			hare = NEXT(hare);
+			start++;
+		}
+	}
+	#undef NEXT
+
+	// Not found. Store everything instead.
+	if (period > SOLVER_MAX_PERIOD) {
+		solver_init_full(solver, rules);
+		return;
+	}
+
+	// The window at `maxmove + start` repeats, and so does every result after it.
+	start += maxmove;
+	long long nbits = start + period;
+	if (rules.pool < nbits) nbits = rules.pool + 1;
+
+	solver_build(solver, rules, nbits);
+	solver->start = start;
+	solver->period = period;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void solver_init_full(Solver* solver, Rules rules) {
+	/*
+		Solves the game by brute force, storing all positions from 0 to `rules.pool`.
+		Kept for pools with no (short enough) period, and to benchmark against.
+
+		@param Solver* solver:	Solver to build.
+		@param Rules rules:		Rules of the game to solve.
+	*/
+	solver_build(solver, rules, rules.pool + 1);
+	solver->start = 0;
+	solver->period = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static inline long long solver_index(const Solver* solver, long long remaining) {
+	/*
+		Maps a position to the stored one with the same result.
+	*/
+	if (remaining < solver->nbits) return remaining;
+	return solver->start + (remaining - solver->start) % solver->period;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void solver_free(Solver* solver) {
+	/*
+		@param Solver* solver:	Solver whose table to free.
+	*/
+	free(solver->losing);
+	solver->losing = NULL;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool solver_losing(const Solver* solver, long long remaining) {
+	/*
+		@param const Solver* solver:	A built solver.
+		@param long long remaining:		Sticks left. 0 to `rules.pool`.
+		@return bool:					Whether the player to move loses with best play.
+	*/
+	remaining = solver_index(solver, remaining);
+	return solver->losing[remaining >> 6] >> (remaining & 63) & 1;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny solver_move(const Solver* solver, long long remaining) {
+	/*
+		Best pick in O(1). Reads the 64 positions below `remaining` as one word and 
+		ANDs it with the allowed picks. Any hit is a pick that leaves a losing position.
+
+		@param const Solver* solver:	A built solver.
+		@param long long remaining:		Sticks left. 0 to `rules.pool`.
+		@return tiny:					The smallest winning pick, 0 if there is none.
+	*/
+	if (remaining <= 0) return 0;
+
+	// Same window as the original position. Every pick is legal at both.
+	remaining = solver_index(solver, remaining);
+
+	// Bit j of below: whether position remaining-64+j is losing.
+	uint64_t below, mask = solver->revmoves;
+	long long lo = remaining - 64;
+	if (lo < 0) {
+		below = solver->losing[0] << (64 - remaining);
+		mask &= ~0ULL << (64 - remaining); // Picks larger than the pool.
+	} else {
+		int shift = lo & 63;
+		below = solver->losing[lo >> 6] >> shift;
+		if (shift) below |= solver->losing[(lo >> 6) + 1] << (64 - shift);
+	}
+
+	uint64_t hits = below & mask;
+	return hits ? 64 - highest_bit(hits) : 0;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                Subsection: Tablebase                                 //
+// ------------------------------------------------------------------------------------ //
+/*
+	Games of several heaps under the rules of a subtraction game: a move picks from one
+	heap, as many sticks as the rules allow. In misere play, whoever takes the very last
+	stick loses. As in the solver, a player with no legal pick at all loses in normal 
+	play and wins in misere play.
+
+	Every position is stored with its distance to the end: the moves left when the 
+	winner hurries and the loser holds on. The winner follows from it. At distance 0 the
+	game is over, lost in normal play and won in misere play, and every move swaps sides:
+	a position is won if its distance is odd in normal play, even in misere play.
+
+	Heaps are unordered, {3, 5} is {5, 3}. A position is stored once, at the rank of its 
+	heaps sorted a0 <= a1 <= ... in the combinatorial number system:
+		sum over i of C(ai + i, i + 1)
+	That numbers all C(max_heap + nheaps, nheaps) positions from 0 with no gap, and
+	taking sticks always lowers the rank, so the table is built in one pass from 0 up.
+
+	File, all numbers little endian. Header, TABLEBASE_HEADER_SIZE bytes:
+		0	magic		TABLEBASE_MAGIC, 4 bytes.
+		4	version		TABLEBASE_VERSION, 1 byte.
+		5	misere		1 byte, 0 or 1.
+		6	nheaps		1 byte.
+		7	entry_bytes	1 byte. 1, or 2 if distances can pass 255.
+		8	max_heap	8 bytes.
+		16	moves		8 bytes. Bit s-1 set means s may be picked, as in `Rules`.
+		24	npositions	8 bytes.
+	Then npositions distances of entry_bytes each, by rank.
+
+	Three heaps of up to 21 sticks take 2 KB, eight take 4 MB. The file is mapped 
+	read-only and shared: any number of games play from one copy in the page cache, 
+	and none of them solves anything at startup.
+*/
+
+static long long tb_choose(long long n, tiny r) {
+	/*
+		@return long long:	C(n, r). 0 if n < r. Callers keep it under TABLEBASE_MAX_POSITIONS.
+	*/
+	if (n < r) return 0;
+	long long c = 1;
+	for (tiny j = 1; j <= r; j++) c = c * (n - r + j) / j; // C(n - r + j, j). Exact.
+	return c;
+}
+
+static long long tb_rank(const int sorted[], tiny nheaps) {
+	/*
+		@param const int sorted[]:	Heaps, smallest first.
+		@return long long:			Rank of the position. See `Subsection: Tablebase`.
+	*/
+	long long rank = 0;
+	for (tiny i = 0; i < nheaps; i++) rank += tb_choose(sorted[i] + i, i + 1);
+	return rank;
+}
+
+static bool tb_better(const Rules* rules, int dtm, bool* win, int* best) {
+	/*
+		Whether a move to a position at distance `dtm` beats the best move so far, 
+		and if so makes it the best. Moves to lost positions beat the rest, the shortest
+		first. Otherwise the longest, to hold on.
+
+		@param const Rules* rules:	Rules of the game.
+		@param int dtm:				Distance of the position the move leads to.
+		@param bool* win:			Whether the best move so far wins.
+		@param int* best:			Its distance. -1 before the first move.
+		@return bool:				true if the move is the new best.
+	*/
+	bool lost = (dtm & 1) == rules->misere;
+	if (lost ? *win && dtm >= *best : *win || dtm <= *best) return false;
+	*win = lost;
+	*best = dtm;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+long long tablebase_positions(long long max_heap, tiny nheaps) {
+	/*
+		@param long long max_heap:	Largest heap.
+		@param tiny nheaps:			Number of heaps.
+		@return long long:			Positions in the table, C(max_heap + nheaps, nheaps).
+									-1 past TABLEBASE_MAX_POSITIONS.
+	*/
+	long long c = 1;
+	for (tiny i = 1; i <= nheaps; i++) {
+		c = c * (max_heap + i) / i; // C(max_heap + i, i). Exact.
+		if (c > TABLEBASE_MAX_POSITIONS) return -1;
+	}
+	return c;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool tablebase_build(Tablebase* tb, Rules rules, tiny nheaps) {
+	/*
+		Solves every position of `nheaps` heaps of 0 to `rules.pool` sticks. Offline: 
+		this is the generator. The table is built in memory, as it will be saved.
+		Free with `tablebase_free`.
+
+		@param Tablebase* tb:	Table to build.
+		@param Rules rules:		Picks and play. `pool` is the largest heap.
+		@param tiny nheaps:		Number of heaps. 1 to TABLEBASE_MAX_HEAPS.
+		@return bool:			false if the table would be too large.
+	*/
+	long long npositions = tablebase_positions(rules.pool, nheaps);
+	if (nheaps < 1 || nheaps > TABLEBASE_MAX_HEAPS || rules.pool < 0 || npositions < 0
+		|| rules.pool * nheaps > TABLEBASE_MAX_STICKS) return false;
+
+	tiny entry_bytes = rules.pool * nheaps > 255 ? 2 : 1; // No game lasts more moves than sticks.
+	size_t size = TABLEBASE_HEADER_SIZE + npositions * entry_bytes;
+	uint8_t* data = malloc(size);
+
+	// Every rank needs a few binomials per move. Looked up, not worked out.
+	long long nrows = rules.pool + nheaps;
+	long long (*choose)[TABLEBASE_MAX_HEAPS + 1] = malloc(nrows * sizeof(*choose));
+	if (!data || !choose) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+	memset(data, 0, TABLEBASE_HEADER_SIZE);
+	memcpy(data, TABLEBASE_MAGIC, 4);
+	data[4] = TABLEBASE_VERSION;
+	data[5] = rules.misere;
+	data[6] = nheaps;
+	data[7] = entry_bytes;
+	put_le(data + 8, rules.pool, 8);
+	put_le(data + 16, rules.moves, 8);
+	put_le(data + 24, npositions, 8);
+	*tb = (Tablebase) {data, size, rules, nheaps, entry_bytes, npositions, false};
+	for (long long n = 0; n < nrows; n++) {
+		for (tiny r = 0; r <= nheaps; r++) choose[n][r] = r ? (n ? choose[n - 1][r - 1] + choose[n - 1][r] : 0) : 1;
+	}
+
+	// Positions in rank order: the heaps count up like an odometer, smallest first.
+	int heaps[TABLEBASE_MAX_HEAPS] = {0};
+	for (long long rank = 0; rank < npositions; rank++) {
+		bool win = false;
+		int best = -1;
+		for (tiny i = 0; i < nheaps; i++) {
+			if (i && heaps[i] == heaps[i - 1]) continue; // Same heap, same moves.
+
+			for (uint64_t legal = legal_moves(&rules, heaps[i]); legal; legal &= legal - 1) {
+				int child[TABLEBASE_MAX_HEAPS], left = heaps[i] - (highest_bit(legal & -legal) + 1);
+				memcpy(child, heaps, nheaps * sizeof(int));
+				tiny j = i;
+				for (; j > 0 && child[j - 1] > left; j--) child[j] = child[j - 1]; // Sorted again.
+				child[j] = left;
+
+				long long at = 0;
+				for (tiny k = 0; k < nheaps; k++) at += choose[child[k] + k][k + 1];
+				tb_better(&rules, tablebase_at(tb, at), &win, &best);
+			}
+		}
+
+		int dtm = best + 1; // 0 with no move at all.
+		if (entry_bytes == 1) data[TABLEBASE_HEADER_SIZE + rank] = dtm;
+		else put_le(data + TABLEBASE_HEADER_SIZE + 2 * rank, dtm, 2);
+
+		for (tiny i = 0; i < nheaps; i++) {
+			if (i < nheaps - 1 ? heaps[i] < heaps[i + 1] : heaps[i] < rules.pool) {
+				heaps[i]++;
+				for (tiny j = 0; j < i; j++) heaps[j] = 0;
+				break;
+			}
+		}
+	}
+	free(choose);
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool tablebase_save(const Tablebase* tb, const char* path) {
+	/*
+		@param const Tablebase* tb:	A built table.
+		@param const char* path:	Where to write it. Replaced if it exists.
+		@return bool:				false if it could not be written.
+	*/
+	FILE* file = fopen(path, "wb");
+	if (!file) return false;
+	bool ok = fwrite(tb->data, 1, tb->size, file) == tb->size;
+	return !fclose(file) && ok;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool tablebase_map(Tablebase* tb, const char* path) {
+	/*
+		Maps a saved table into memory, read-only and shared. Nothing is read until
+		positions are looked up, and then only their pages.
+
+		@param Tablebase* tb:		Table to open.
+		@param const char* path:	The file.
+		@return bool:				false if the file cannot be read, or is not a tablebase.
+	*/
+	*tb = (Tablebase) {0};
+
+	#ifdef _WIN32
+		FILE* file = fopen(path, "rb");
+		if (!file) return false;
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		uint8_t* data = size > 0 ? malloc(size) : NULL;
+		rewind(file);
+		if (data && fread(data, 1, size, file) == (size_t) size) {
+			tb->data = data;
+			tb->size = size;
+		} else free(data);
+		fclose(file);
+	#else
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) return false;
+		struct stat info;
+		if (!fstat(fd, &info) && info.st_size > 0) {
+			void* data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			if (data != MAP_FAILED) {
+				madvise(data, info.st_size, MADV_RANDOM); // Lookups jump around. No read ahead.
+				tb->data = data;
+				tb->size = info.st_size;
+				tb->mapped = true;
+			}
+		}
+		close(fd); // The mapping stays.
+	#endif
+
+	const uint8_t* header = tb->data;
+	if (tb->size < TABLEBASE_HEADER_SIZE || memcmp(header, TABLEBASE_MAGIC, 4)
+			|| header[4] != TABLEBASE_VERSION) {
+		tablebase_free(tb);
+		return false;
+	}
+
+	tb->rules = (Rules) {
+		.pool = get_le(header + 8, 8),
+		.moves = get_le(header + 16, 8),
+		.misere = header[5]
+	};
+	tb->nheaps = header[6];
+	tb->entry_bytes = header[7];
+	tb->npositions = get_le(header + 24, 8);
+
+	// Checked once here, so lookups trust the file.
+	if (tb->nheaps < 1 || tb->nheaps > TABLEBASE_MAX_HEAPS || tb->rules.pool < 0
+			|| tb->rules.pool * tb->nheaps > TABLEBASE_MAX_STICKS
+			|| (tb->entry_bytes != 1 && tb->entry_bytes != 2)
+			|| tb->npositions != tablebase_positions(tb->rules.pool, tb->nheaps)
+			|| tb->size != TABLEBASE_HEADER_SIZE + (size_t) tb->npositions * tb->entry_bytes) {
+		tablebase_free(tb);
+		return false;
+	}
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void tablebase_free(Tablebase* tb) {
+	/*
+		@param Tablebase* tb:	Table to unmap, or to free if it was built or read.
+	*/
+	#ifndef _WIN32
+		if (tb->mapped) munmap((void*) tb->data, tb->size);
+		else free((void*) tb->data);
+	#else
+		free((void*) tb->data);
+	#endif
+	*tb = (Tablebase) {0};
+}
+
+// ------------------------------------------------------------------------------------ //
+
+long long tablebase_index(const Tablebase* tb, const int heaps[]) {
+	/*
+		@param const Tablebase* tb:	A table.
+		@param const int heaps[]:	`nheaps` heaps, in any order, of 0 to `rules.pool` sticks.
+		@return long long:			Where the position is stored.
+	*/
+	int sorted[TABLEBASE_MAX_HEAPS];
+	for (tiny i = 0; i < tb->nheaps; i++) {
+		tiny j = i;
+		for (; j > 0 && sorted[j - 1] > heaps[i]; j--) sorted[j] = sorted[j - 1];
+		sorted[j] = heaps[i];
+	}
+	return tb_rank(sorted, tb->nheaps);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+int tablebase_at(const Tablebase* tb, long long rank) {
+	/*
+		@param const Tablebase* tb:	A table.
+		@param long long rank:		0 to `npositions` - 1.
+		@return int:				Distance to the end of the position stored there.
+	*/
+	const uint8_t* at = tb->data + TABLEBASE_HEADER_SIZE + rank * tb->entry_bytes;
+	return tb->entry_bytes == 1 ? *at : (int) get_le(at, 2);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+int tablebase_dtm(const Tablebase* tb, const int heaps[]) {
+	/*
+		@param const Tablebase* tb:	A table.
+		@param const int heaps[]:	A position, as for `tablebase_index`.
+		@return int:				Moves to the end of the game, with best play.
+	*/
+	return tablebase_at(tb, tablebase_index(tb, heaps));
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool tablebase_win(const Tablebase* tb, const int heaps[]) {
+	/*
+		@param const Tablebase* tb:	A table.
+		@param const int heaps[]:	A position, as for `tablebase_index`.
+		@return bool:				Whether the player to move wins with best play.
+	*/
+	return (tablebase_dtm(tb, heaps) & 1) != tb->rules.misere;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool tablebase_move(const Tablebase* tb, const int heaps[], tiny* heap, tiny* pick) {
+	/*
+		The perfect move: the fastest win, or else the longest loss.
+
+		@param const Tablebase* tb:	A table.
+		@param const int heaps[]:	A position, as for `tablebase_index`.
+		@param tiny* heap:			Set to the heap to pick from, an index into `heaps`.
+		@param tiny* pick:			Set to the sticks to pick.
+		@return bool:				false if there is no legal move. 
+	*/
+	bool win = false;
+	int best = -1, child[TABLEBASE_MAX_HEAPS];
+	memcpy(child, heaps, tb->nheaps * sizeof(int));
+	for (tiny i = 0; i < tb->nheaps; i++) {
+		for (uint64_t legal = legal_moves(&tb->rules, heaps[i]); legal; legal &= legal - 1) {
+			tiny s = highest_bit(legal & -legal) + 1;
+			child[i] = heaps[i] - s;
+			if (tb_better(&tb->rules, tablebase_dtm(tb, child), &win, &best)) *heap = i, *pick = s;
+		}
+		child[i] = heaps[i];
+	}
+	return best >= 0;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                 Subsection: Grundy                                   //
+// ------------------------------------------------------------------------------------ //
+/*
+	Sprague-Grundy values, to play several piles without a table of every position.
+	The value of a pile is the mex (smallest value missing) of the values of the piles
+	one pick away. In normal play, a sum of piles is lost for the player to move exactly
+	when the XOR of its values is 0, and a winning move is one that makes it 0.
+
+	Misere play needs a correction. A pile is tame if it plays like a heap of misere Nim:
+	its misere value (the same mex, with a pile that has no pick worth 1 instead of 0) is 
+	its normal value when that is 2 or more, and the other of 0 and 1 when it is 0 or 1.
+	Sums of tame piles follow Nim's misere rule: play as in normal play, except when every
+	pile has value 0 or 1, where the player to move loses on an odd number of 1s.
+	The game's own rules, picks 1-4, are tame. Rules that are not still get values, 
+	but their misere sums need the tablebase.
+
+	Values are found bottom up with one 64-bit window per value over the last 64 piles, 
+	kept as a ring: pile m is bit ~m % 64 of windows[v] if its value is v. Rotated by the 
+	pile, the legal picks line up with the ring, so `windows[v] & reach` tells in one AND 
+	whether any pick reaches value v, and the mex is the first value whose window misses. 
+	A new pile only clears the bit of the one it replaces and sets its own. No value is 
+	read back from the table: the work per pile is its value + 1 ANDs, however many picks.
+*/
+
+static void grundy_fill(uint8_t* values, const Rules* rules, tiny nopick) {
+	/*
+		@param uint8_t* values:		Filled with the value of each pile, 0 to `rules->pool`.
+		@param const Rules* rules:	Picks of the game.
+		@param tiny nopick:			Value of a pile with no legal pick. 0, or 1 for misere values.
+	*/
+	uint64_t windows[66] = {0}; // 64 picks reach at most 64 values: the mex is at most 64.
+	uint8_t ring[64] = {0};	 // Value of each pile in the ring, by slot.
+
+	long long n = 0;
+	for (; n <= rules->pool && n < 64; n++) {
+		uint64_t legal = legal_moves(rules, n);
+		tiny slot = ~n & 63, shift = -n & 63;
+		uint64_t reach = shift ? legal << shift | legal >> (64 - shift) : legal; // Pick s to slot ~(n-s).
+
+		tiny value = nopick;
+		if (legal) for (value = 0; windows[value] & reach; value++);
+		values[n] = value;
+		windows[value] |= 1ULL << slot;
+		ring[slot] = value;
+	}
+
+	// From 64 on, every pick is legal and the ring is full: `reach` turns one slot a pile.
+	uint64_t reach = rules->moves;
+	for (; n <= rules->pool; n++) {
+		tiny slot = ~n & 63;
+		tiny value = 0;
+		while (windows[value] & reach) value++;
+		values[n] = value;
+
+		windows[ring[slot]] &= ~(1ULL << slot); // Pile n - 64 leaves.
+		windows[value] |= 1ULL << slot;
+		ring[slot] = value;
+		reach = reach >> 1 | reach << 63;
+	}
+}
+
+static void grundy_fill_scalar(uint8_t* values, const Rules* rules, tiny nopick) {
+	/*
+		Same as `grundy_fill`, the textbook way: reads the value of every pick back from
+		the table, and looks for the mex one value at a time. The benchmark's baseline.
+	*/
+	for (long long n = 0; n <= rules->pool; n++) {
+		uint64_t legal = legal_moves(rules, n);
+		if (!legal) {
+			values[n] = nopick;
+			continue;
+		}
+
+		bool seen[65] = {false};
+		for (; legal; legal &= legal - 1) seen[values[n - (highest_bit(legal & -legal) + 1)]] = true;
+		tiny value = 0;
+		while (seen[value]) value++;
+		values[n] = value;
+	}
+}
+
+static void grundy_build(Grundy* grundy, Rules rules, bool scalar) {
+	/*
+		Fills both tables and works out whether the piles are tame.
+	*/
+	*grundy = (Grundy) {.rules = rules};
+	grundy->values = malloc(rules.pool + 1);
+	if (rules.misere) grundy->misere_values = malloc(rules.pool + 1);
+	if (!grundy->values || (rules.misere && !grundy->misere_values)) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+
+	(scalar ? grundy_fill_scalar : grundy_fill)(grundy->values, &rules, 0);
+	if (rules.misere) (scalar ? grundy_fill_scalar : grundy_fill)(grundy->misere_values, &rules, 1);
+
+	grundy->tame = true;
+	for (long long n = 0; n <= rules.pool; n++) {
+		tiny value = grundy->values[n];
+		if (value > grundy->max_value) grundy->max_value = value;
+		if (rules.misere) grundy->tame &= grundy->misere_values[n] == (value > 1 ? value : (value ^ 1));
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void grundy_init(Grundy* grundy, Rules rules) {
+	/*
+		Finds the value of every pile from 0 to `rules.pool` sticks. Free with `grundy_free`.
+
+		@param Grundy* grundy:	Values to build.
+		@param Rules rules:		Picks and play. `pool` is the largest pile.
+	*/
+	grundy_build(grundy, rules, false);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void grundy_init_scalar(Grundy* grundy, Rules rules) {
+	/*
+		Same as `grundy_init`, one pick at a time. Kept to benchmark against.
+
+		@param Grundy* grundy:	Values to build.
+		@param Rules rules:		Picks and play. `pool` is the largest pile.
+	*/
+	grundy_build(grundy, rules, true);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void grundy_free(Grundy* grundy) {
+	/*
+		@param Grundy* grundy:	Values to free.
+	*/
+	free(grundy->values);
+	free(grundy->misere_values);
+	*grundy = (Grundy) {0};
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool grundy_win(const Grundy* grundy, const long long piles[], tiny npiles) {
+	/*
+		Whether the player to move wins a sum of piles, with the misere correction.
+		Exact in normal play, and in misere play if the piles are `tame`.
+
+		@param const Grundy* grundy:	Built values.
+		@param const long long piles[]:	Sticks in each pile, 0 to `rules.pool`.
+		@param tiny npiles:				Number of piles.
+		@return bool:					Whether the player to move wins with best play.
+	*/
+	tiny sum = 0;
+	bool big = false; // Some pile is worth 2 or more.
+	for (tiny i = 0; i < npiles; i++) {
+		tiny value = grundy->values[piles[i]];
+		sum ^= value;
+		big |= value > 1;
+	}
+	if (!grundy->rules.misere || big) return sum != 0;
+	return sum == 0; // Only 0s and 1s: an even number of 1s wins.
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool grundy_move(const Grundy* grundy, const long long piles[], tiny npiles, tiny* pile, tiny* pick) {
+	/*
+		A winning move: the first pick, in pile order, that leaves a lost sum.
+
+		@param const Grundy* grundy:	Built values.
+		@param const long long piles[]:	Sticks in each pile, 0 to `rules.pool`. At most 64 piles.
+		@param tiny npiles:				Number of piles.
+		@param tiny* pile:				Set to the pile to pick from.
+		@param tiny* pick:				Set to the sticks to pick.
+		@return bool:					false if the sum is lost: no move wins.
+	*/
+	long long after[64];
+	memcpy(after, piles, npiles * sizeof(long long));
+	for (tiny i = 0; i < npiles; i++) {
+		for (uint64_t legal = legal_moves(&grundy->rules, piles[i]); legal; legal &= legal - 1) {
+			tiny s = highest_bit(legal & -legal) + 1;
+			after[i] = piles[i] - s;
+			if (!grundy_win(grundy, after, npiles)) {
+				*pile = i;
+				*pick = s;
+				return true;
+			}
+		}
+		after[i] = piles[i];
+	}
+	return false;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                Subsection: Retrograde                                //
+// ------------------------------------------------------------------------------------ //
+/*
+	Variants with no period to find and no Grundy rule to lean on: each player has picks
+	of their own, and with `no_repeat` the picks depend on the last one. A state is the
+	sticks left, the player to move and the last pick, numbered
+		state = (remaining * 2 + player) * nlast + last
+	so the states one pick above any state, its predecessors, are one contiguous run.
+
+	Solved backwards from the states with no legal pick (won in misere play, lost in
+	normal play, as in `solver_build`), on every thread at once:
+	- Each state starts with a counter of its unsolved picks, one byte in `counts`.
+	- A solved state is pushed to the frontier. Threads take runs of it and visit the
+	  predecessors: a lost state makes every predecessor won, a won one takes one off 
+	  each predecessor's counter, and whichever takes it to 0 makes that one lost.
+	- A counter turns into the result, RETRO_WON or RETRO_LOST, with a compare-and-swap.
+	  So exactly one thread solves each state, and pushes it once.
+	- The frontier is one queue with a slot for every state, so it never wraps. A thread
+	  reserves a run of slots with one atomic add and fills them; others take runs of what
+	  is reserved with a compare-and-swap on the head. Nothing waits on a lock.
+	The threads start on contiguous runs of states, then share the frontier as it comes.
+	Once every state is visited, the counters are packed to one bit per state.
+
+	Memory: 9 bytes per state while solving (the counter and the queue slot), 1 bit after.
+*/
+
+short count_cores(void) {
+	/*
+		@return short:	Cores online. At least 1, at most MAX_THREADS.
+	*/
+	long n;
+	#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		n = info.dwNumberOfProcessors;
+	#else
+		n = sysconf(_SC_NPROCESSORS_ONLN);
+	#endif
+	if (n < 1) n = 1;
+	return n > MAX_THREADS ? MAX_THREADS : n;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static tiny retro_nlast(const Variant* variant) {
+	/*
+		Last picks that need telling apart: none, or 0 (no pick yet) to the largest pick.
+	*/
+	if (!variant->no_repeat) return 1;
+	return highest_bit(variant->moves[HUMAN] | variant->moves[COMPUTER]) + 2;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+long long retro_states(const Variant* variant) {
+	/*
+		@param const Variant* variant:	Rules of the game.
+		@return long long:				States `retro_solve` solves, and stores a bit for.
+	*/
+	return (variant->pool + 1) * 2 * retro_nlast(variant);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+uint64_t retro_legal(const Variant* variant, long long remaining, PLAYER player, tiny last) {
+	/*
+		@param const Variant* variant:	Rules of the game.
+		@param long long remaining:		Sticks left in the pool.
+		@param PLAYER player:			Player to move.
+		@param tiny last:				What the other player just picked, 0 if nothing.
+		@return uint64_t:				Picks `player` may make. Bit s-1 for s.
+	*/
+	if (remaining <= 0) return 0;
+	uint64_t legal = variant->moves[player];
+	if (remaining < 64) legal &= (1ULL << remaining) - 1;
+	if (variant->no_repeat && last) legal &= ~(1ULL << (last - 1));
+	return legal;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void retro_flush(RetroWorker* worker) {
+	/*
+		Pushes the worker's solved states: reserves their slots, then fills them.
+	*/
+	RetroJob* job = worker->job;
+	if (!worker->nbuf) return;
+	long long slot = atomic_fetch_add_explicit(&job->tail, worker->nbuf, memory_order_relaxed);
+	for (short k = 0; k < worker->nbuf; k++) 
+		atomic_store_explicit(&job->queue[slot + k], worker->buf[k], memory_order_release);
+	worker->nbuf = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void retro_push(RetroWorker* worker, long long state, bool won) {
+	/*
+		Holds a solved state until the worker has a batch of them.
+	*/
+	worker->buf[worker->nbuf++] = (uint64_t) state << 2 | 2 | won;
+	if (worker->nbuf == RETRO_BATCH) retro_flush(worker);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void retro_settle(RetroWorker* worker, long long state, bool child_won) {
+	/*
+		One pick of `state` leads to a solved state. A lost one makes `state` won, 
+		and the last won one makes it lost. Whoever solves it pushes it.
+	*/
+	_Atomic uint8_t* count = &worker->job->counts[state];
+	uint8_t c = atomic_load_explicit(count, memory_order_relaxed);
+	while (c < RETRO_WON) {
+		uint8_t next = !child_won ? RETRO_WON : c == 1 ? RETRO_LOST : c - 1;
+		if (atomic_compare_exchange_weak_explicit(count, &c, next, 
+				memory_order_relaxed, memory_order_relaxed)) {
+			if (next >= RETRO_WON) retro_push(worker, state, next == RETRO_WON);
+			return;
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void retro_visit(RetroWorker* worker, uint64_t slot) {
+	/*
+		Settles every predecessor of a solved state: the states one pick of the other 
+		player above it.
+	*/
+	const RetroJob* job = worker->job;
+	const Variant* variant = job->variant;
+	long long state = slot >> 2, at = state / job->nlast;
+	tiny last = state % job->nlast;
+	long long remaining = at >> 1;
+	PLAYER other = !(at & 1);
+	bool won = slot & 1;
+
+	// Without `no_repeat`, the pick that led here is not kept: any of the other's.
+	uint64_t picks = variant->moves[other];
+	if (job->nlast > 1) picks &= last ? 1ULL << (last - 1) : 0;
+	for (; picks; picks &= picks - 1) {
+		tiny s = highest_bit(picks & -picks) + 1;
+		if (remaining + s > variant->pool) break; // Picks come smallest first.
+
+		long long first = ((remaining + s) * 2 + other) * job->nlast;
+		if (job->nlast == 1) retro_settle(worker, first, won);
+		else for (tiny k = 0; k < job->nlast; k++) if (k != s) retro_settle(worker, first + k, won);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void* retro_seed(void* arg) {
+	/*
+		First pass, over the worker's run of states: counts the legal picks of each.
+		States with none are solved already, and start the frontier.
+	*/
+	RetroWorker* worker = arg;
+	RetroJob* job = worker->job;
+	long long from = job->nstates * worker->id / job->nthreads;
+	long long to = job->nstates * (worker->id + 1) / job->nthreads;
+
+	for (long long state = from; state < to; state++) {
+		long long at = state / job->nlast;
+		uint64_t legal = retro_legal(job->variant, at >> 1, at & 1, state % job->nlast);
+		uint8_t count = count_bits(legal);
+		if (!count) {
+			count = job->variant->misere ? RETRO_WON : RETRO_LOST;
+			retro_push(worker, state, job->variant->misere);
+		}
+		atomic_init(&job->counts[state], count);
+	}
+	retro_flush(worker);
+	return NULL;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void* retro_propagate(void* arg) {
+	/*
+		Takes runs of the frontier and visits them until every state is visited.
+		Only takes slots already reserved, whose writer is about to fill them.
+	*/
+	RetroWorker* worker = arg;
+	RetroJob* job = worker->job;
+
+	INF_LOOP {
+		long long head = atomic_load_explicit(&job->head, memory_order_relaxed);
+		long long tail = atomic_load_explicit(&job->tail, memory_order_relaxed);
+		if (head >= tail) {
+			// Nothing to take. Push what this thread holds, or wait for the others.
+			if (worker->nbuf) retro_flush(worker);
+			else if (atomic_load_explicit(&job->done, memory_order_acquire) >= job->nstates) break;
+			else sched_yield();
+			continue;
+		}
+
+		// A fair share of what is there, so a thin frontier still feeds every thread.
+		long long take = (tail - head + job->nthreads - 1) / job->nthreads;
+		if (take > RETRO_CLAIM) take = RETRO_CLAIM;
+		if (!atomic_compare_exchange_weak_explicit(&job->head, &head, head + take, 
+				memory_order_relaxed, memory_order_relaxed)) continue;
+
+		for (long long i = head; i < head + take; i++) {
+			uint64_t slot;
+			while (!(slot = atomic_load_explicit(&job->queue[i], memory_order_acquire))) sched_yield();
+			retro_visit(worker, slot);
+		}
+		retro_flush(worker); // What it solved, for the threads waiting on it.
+		atomic_fetch_add_explicit(&job->done, take, memory_order_release);
+	}
+	return NULL;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void* retro_pack(void* arg) {
+	/*
+		Last pass, over the worker's run of words: one bit per state, set if won.
+	*/
+	RetroWorker* worker = arg;
+	RetroJob* job = worker->job;
+	long long nwords = (job->nstates + 63) / 64;
+	long long from = nwords * worker->id / job->nthreads;
+	long long to = nwords * (worker->id + 1) / job->nthreads;
+
+	for (long long w = from; w < to; w++) {
+		uint64_t bits = 0;
+		long long end = w * 64 + 64 < job->nstates ? w * 64 + 64 : job->nstates;
+		for (long long state = w * 64; state < end; state++) {
+			uint8_t count = atomic_load_explicit(&job->counts[state], memory_order_relaxed);
+			bits |= (uint64_t) (count == RETRO_WON) << (state & 63);
+		}
+		job->winning[w] = bits;
+	}
+	return NULL;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void retro_run(RetroJob* job, RetroWorker* workers, void* (*pass)(void*)) {
+	/*
+		Runs one pass on every thread of the job, and waits for all of them.
+	*/
+	pthread_t threads[MAX_THREADS];
+	for (short t = 0; t < job->nthreads; t++) {
+		workers[t] = (RetroWorker) {.job = job, .id = t};
+		if (pthread_create(&threads[t], NULL, pass, &workers[t])) {
+			fprintf(stderr, "Could not start thread %d.\n", t);
+			exit(1);
+		}
+	}
+	for (short t = 0; t < job->nthreads; t++) pthread_join(threads[t], NULL);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool retro_solve(Retro* retro, Variant variant, short nthreads) {
+	/*
+		Solves every state of the variant backwards, on `nthreads` threads.
+		The result does not depend on the number of threads. Free with `retro_free`.
+
+		@param Retro* retro:		Results to fill.
+		@param Variant variant:		Rules of the game.
+		@param short nthreads:		Threads to solve on. 1 to MAX_THREADS.
+		@return bool:				false if the states do not fit in memory.
+	*/
+	if (nthreads < 1) nthreads = 1;
+	if (nthreads > MAX_THREADS) nthreads = MAX_THREADS;
+
+	*retro = (Retro) {.variant = variant, .nlast = retro_nlast(&variant)};
+	retro->nstates = retro_states(&variant);
+	RetroJob job = {
+		.variant = &retro->variant,
+		.nlast = retro->nlast,
+		.nstates = retro->nstates,
+		.counts = malloc(retro->nstates),
+		.queue = calloc(retro->nstates, sizeof(uint64_t)),
+		.winning = calloc((retro->nstates + 63) / 64, sizeof(uint64_t)),
+		.nthreads = nthreads
+	};
+	RetroWorker* workers = malloc(nthreads * sizeof(RetroWorker));
+	if (!job.counts || !job.queue || !job.winning || !workers) {
+		free(job.counts);
+		free(job.queue);
+		free(job.winning);
+		free(workers);
+		return false;
+	}
+	atomic_init(&job.head, 0);
+	atomic_init(&job.tail, 0);
+	atomic_init(&job.done, 0);
+
+	retro_run(&job, workers, retro_seed);
+	retro_run(&job, workers, retro_propagate);
+	retro_run(&job, workers, retro_pack);
+
+	#ifdef DEBUG
+		fprintf(stderr, "[retro_solve] %lld states on %d threads, %lld visited.\n", 
+			job.nstates, nthreads, (long long) atomic_load(&job.done));
+	#endif
+
+	free(job.counts);
+	free(job.queue);
+	free(workers);
+	retro->winning = job.winning;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool retro_solve_dp(Retro* retro, Variant variant) {
+	/*
+		Same as `retro_solve`, forwards on one thread: every state after the states its
+		picks lead to. Kept to check the solver against, and to benchmark it.
+
+		@param Retro* retro:		Results to fill.
+		@param Variant variant:		Rules of the game.
+		@return bool:				false if the states do not fit in memory.
+	*/
+	*retro = (Retro) {.variant = variant, .nlast = retro_nlast(&variant)};
+	retro->nstates = retro_states(&variant);
+	retro->winning = calloc((retro->nstates + 63) / 64, sizeof(uint64_t));
+	if (!retro->winning) return false;
+
+	for (long long state = 0; state < retro->nstates; state++) {
+		long long at = state / retro->nlast, remaining = at >> 1;
+		PLAYER player = at & 1;
+		uint64_t legal = retro_legal(&variant, remaining, player, state % retro->nlast);
+		bool won = !legal && variant.misere;
+		for (; legal && !won; legal &= legal - 1) {
+			tiny s = highest_bit(legal & -legal) + 1;
+			won = !retro_win(retro, remaining - s, !player, s);
+		}
+		retro->winning[state >> 6] |= (uint64_t) won << (state & 63);
+	}
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void retro_free(Retro* retro) {
+	/*
+		@param Retro* retro:	Results to free.
+	*/
+	free(retro->winning);
+	retro->winning = NULL;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+long long retro_index(const Retro* retro, long long remaining, PLAYER player, tiny last) {
+	/*
+		@param const Retro* retro:		Solved states.
+		@param long long remaining:		Sticks left. 0 to `variant.pool`.
+		@param PLAYER player:			Player to move.
+		@param tiny last:				What the other player just picked, 0 if nothing.
+		@return long long:				The state's bit in `winning`.
+	*/
+	return (remaining * 2 + player) * retro->nlast + (retro->nlast > 1 ? last : 0);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool retro_win(const Retro* retro, long long remaining, PLAYER player, tiny last) {
+	/*
+		@return bool:	Whether `player`, to move, wins with best play. See `retro_index`.
+	*/
+	long long state = retro_index(retro, remaining, player, last);
+	return retro->winning[state >> 6] >> (state & 63) & 1;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny retro_move(const Retro* retro, long long remaining, PLAYER player, tiny last) {
+	/*
+		@return tiny:	The smallest pick that leaves the other player lost, 0 if there is 
+						none. See `retro_index`.
+	*/
+	uint64_t legal = retro_legal(&retro->variant, remaining, player, last);
+	for (; legal; legal &= legal - 1) {
+		tiny s = highest_bit(legal & -legal) + 1;
+		if (!retro_win(retro, remaining - s, !player, s)) return s;
+	}
+	return 0;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                Subsection: Strategies                                //
+// ------------------------------------------------------------------------------------ //
+/*
+	How the computer picks, behind one table of functions, `StrategyOps`:
+	- table: the solver's lookup. Perfect, in O(1).
+	- alphabeta: negamax search with alpha-beta pruning, as a program without the solver
+	  would play. Searches one ply deeper at a time until the position is proven or the
+	  time per pick runs out, then plays the best pick of the deepest search it finished.
+	- human: the same search, a few plies deep, picking at random between picks that look
+	  as good as each other. Perfect near the end and guessing before, as people play.
+	- tablebase and retro: lookups in a mapped tablebase or a retrograde solve, of a game
+	  with the same picks. Perfect too: one heap has a single winning pick. Retro is told
+	  the other player's last pick, so it plays variants that bar repeats as well.
+
+	Scores are from the player to move: SEARCH_WIN - k if it wins in k plies, the negative
+	if it loses in k, 0 if the search could not tell. Being relative to the position, not
+	to the root, they are kept in the transposition table and reused from any path.
+	Positions are keyed Zobrist style, with a random key per pile. One heap has only the 
+	one feature, and both players have the same picks, so who is to move is not in the key.
+	Proven scores stand at any depth: the table keeps them with SEARCH_EXACT.
+*/
+
+static inline int search_parent(int score) {
+	/*
+		A score seen one ply up: the other player's, and one ply further from the end.
+	*/
+	return score > 0 ? -score + 1 : score < 0 ? -score - 1 : 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static inline int search_child(int bound) {
+	/*
+		A bound of the alpha-beta window seen one ply down. The inverse of `search_parent`.
+	*/
+	return bound > 0 ? -(bound + 1) : bound < 0 ? -(bound - 1) : 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static int search(Strategy* strategy, long long remaining, int depth, int alpha, int beta) {
+	/*
+		@param Strategy* strategy:		The search. Counts its nodes, and stops on time.
+		@param long long remaining:		Sticks left.
+		@param int depth:				Plies to look ahead.
+		@param int alpha, beta:			Window. Scores outside it are only bounds.
+		@return int:					Score of the position. See `Subsection: Strategies`.
+	*/
+	strategy->nodes++;
+	if (strategy->deadline && !(strategy->nodes & 1023) && monotonic_ns() > strategy->deadline) 
+		strategy->stopped = true;
+	if (strategy->stopped) return 0;
+
+	uint64_t legal = legal_moves(&strategy->rules, remaining);
+	if (!legal) return strategy->rules.misere ? SEARCH_WIN : -SEARCH_WIN;
+	if (depth <= 0) return 0; // Cannot tell.
+
+	uint64_t key = strategy->zobrist[remaining];
+	SearchEntry* entry = &strategy->table[key & ((1 << SEARCH_TT_BITS) - 1)];
+	tiny first = 0;
+	if (entry->key == key) {
+		strategy->hits++;
+		if (legal >> (entry->move - 1) & 1) first = entry->move;
+		if (entry->depth >= depth) {
+			if (entry->bound == SEARCH_BOUND_EXACT) return entry->score;
+			if (entry->bound == SEARCH_BOUND_LOWER && entry->score > alpha) alpha = entry->score;
+			if (entry->bound == SEARCH_BOUND_UPPER && entry->score < beta) beta = entry->score;
+			if (alpha >= beta) return entry->score;
+		}
+	}
+
+	// The table's pick first: it is most often the best, and cuts the others short.
+	int floor = alpha, best = -SEARCH_WIN - 1;
+	tiny best_move = 0;
+	for (uint64_t todo = legal; todo && alpha < beta; first = 0) {
+		tiny s = first ? first : highest_bit(todo & -todo) + 1;
+		todo &= ~(1ULL << (s - 1));
+
+		int score = search_parent(search(strategy, remaining - s, depth - 1, 
+			search_child(beta), search_child(alpha)));
+		if (strategy->stopped) return 0;
+		if (score > best) best = score, best_move = s;
+		if (score > alpha) alpha = score;
+	}
+
+	SEARCH_BOUND bound = best <= floor ? SEARCH_BOUND_UPPER 
+		: best >= beta ? SEARCH_BOUND_LOWER : SEARCH_BOUND_EXACT;
+	bool proven = (best > SEARCH_PROVEN && bound != SEARCH_BOUND_UPPER) 
+		|| (best < -SEARCH_PROVEN && bound != SEARCH_BOUND_LOWER);
+	*entry = (SearchEntry) {key, best, proven ? SEARCH_EXACT : depth, bound, best_move};
+	return best;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static tiny search_pick(Strategy* strategy, long long remaining, tiny last, Rng* rng) {
+	/*
+		Iterative deepening: searches every pick 1, 2, 3... plies deep, until a search 
+		proves the position, reaches the end of every line, or runs out of time.
+		The pick of the deepest finished search is played.
+	*/
+	uint64_t legal = legal_moves(&strategy->rules, remaining);
+	if (!legal) return 0;
+	strategy->deadline = strategy->budget_ns ? monotonic_ns() + strategy->budget_ns : 0;
+	strategy->stopped = false;
+
+	tiny pick = 0;
+	int score = 0;
+	for (int depth = 1; depth <= strategy->max_depth; depth++) {
+		// Every pick in a full window, so all the best ones are known.
+		int best = -SEARCH_WIN - 1;
+		tiny ties[64], nties = 0;
+		for (uint64_t todo = legal; todo && !strategy->stopped; todo &= todo - 1) {
+			tiny s = highest_bit(todo & -todo) + 1;
+			int value = search_parent(search(strategy, remaining - s, depth - 1, 
+				-SEARCH_WIN - 1, SEARCH_WIN + 1));
+			if (value > best) best = value, nties = 0;
+			if (value == best) ties[nties++] = s;
+		}
+		if (strategy->stopped) break;
+
+		pick = strategy->random_ties ? ties[rng_next(rng) % nties] : ties[0];
+		score = best;
+		strategy->depth = depth;
+		if (best > SEARCH_PROVEN || best < -SEARCH_PROVEN || depth >= remaining) break;
+	}
+
+	if (!pick) return random_move(&strategy->rules, remaining, rng_next(rng)); // Not even 1 ply.
+	return score < -SEARCH_PROVEN ? 0 : pick;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void search_free(Strategy* strategy) {
+	free(strategy->zobrist);
+	free(strategy->table);
+	strategy->zobrist = NULL;
+	strategy->table = NULL;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static tiny table_pick(Strategy* strategy, long long remaining, tiny last, Rng* rng) {
+	strategy->nodes++;
+	return solver_move(strategy->solver, remaining);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static tiny tablebase_pick(Strategy* strategy, long long remaining, tiny last, Rng* rng) {
+	strategy->nodes++;
+	int heaps[TABLEBASE_MAX_HEAPS] = {remaining}; // One heap. The others are empty.
+	tiny heap, pick;
+	if (!tablebase_win(strategy->tablebase, heaps) 
+		|| !tablebase_move(strategy->tablebase, heaps, &heap, &pick)) return 0;
+	return pick;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static tiny retro_pick(Strategy* strategy, long long remaining, tiny last, Rng* rng) {
+	strategy->nodes++;
+	return retro_move(strategy->retro, remaining, COMPUTER, last); // Never the pick it bans.
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static const StrategyOps TABLE_OPS = {"table", table_pick, NULL};
+static const StrategyOps TABLEBASE_OPS = {"tablebase", tablebase_pick, NULL};
+static const StrategyOps RETRO_OPS = {"retro", retro_pick, NULL};
+static const StrategyOps ALPHABETA_OPS = {"alphabeta", search_pick, search_free};
+static const StrategyOps HUMAN_OPS = {"human", search_pick, search_free};
+
+// ------------------------------------------------------------------------------------ //
+
+static bool search_init(Strategy* strategy, const StrategyOps* ops, Rules rules, uint64_t seed) {
+	/*
+		Draws the Zobrist keys and clears the transposition table.
+	*/
+	*strategy = (Strategy) {.ops = ops, .rules = rules};
+	if (rules.pool > SEARCH_MAX_POOL) return false;
+
+	strategy->zobrist = malloc((rules.pool + 1) * sizeof(uint64_t));
+	strategy->table = calloc(1 << SEARCH_TT_BITS, sizeof(SearchEntry));
+	if (!strategy->zobrist || !strategy->table) {
+		search_free(strategy);
+		return false;
+	}
+
+	Rng rng;
+	rng_seed(&rng, seed);
+	for (long long n = 0; n <= rules.pool; n++) strategy->zobrist[n] = rng_next(&rng) | 1; // 0: empty.
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void strategy_table(Strategy* strategy, const Solver* solver) {
+	/*
+		The solver's pick. Needs nothing of its own.
+
+		@param Strategy* strategy:	Strategy to set up.
+		@param const Solver* solver:	A built solver, of the rules to play. Not owned.
+	*/
+	*strategy = (Strategy) {.ops = &TABLE_OPS, .rules = solver->rules, .solver = solver};
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool strategy_tablebase(Strategy* strategy, const Tablebase* tablebase, Rules rules) {
+	/*
+		The tablebase's pick, with the other heaps empty. Needs nothing of its own.
+
+		@param Strategy* strategy:			Strategy to set up.
+		@param const Tablebase* tablebase:	A mapped tablebase. Not owned.
+		@param Rules rules:					Rules to play. The table must have the same picks
+											and heaps of `rules.pool` sticks or more.
+		@return bool:						false if the table does not cover the rules.
+	*/
+	const Rules* tb = &tablebase->rules;
+	if (tb->moves != rules.moves || tb->misere != rules.misere || tb->pool < rules.pool) return false;
+	*strategy = (Strategy) {.ops = &TABLEBASE_OPS, .rules = rules, .tablebase = tablebase};
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void strategy_retro(Strategy* strategy, const Retro* retro) {
+	/*
+		The retrograde solve's pick, as the COMPUTER. Needs nothing of its own.
+
+		@param Strategy* strategy:	Strategy to set up.
+		@param const Retro* retro:	A solved variant, of the rules to play. Not owned.
+	*/
+	Rules rules = {retro->variant.pool, retro->variant.moves[COMPUTER], retro->variant.misere};
+	*strategy = (Strategy) {.ops = &RETRO_OPS, .rules = rules, .retro = retro};
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool strategy_alphabeta(Strategy* strategy, Rules rules, long long budget_ns, uint64_t seed) {
+	/*
+		Alpha-beta search, as deep as `budget_ns` per pick allows. Free with `strategy_free`.
+
+		@param Strategy* strategy:	Strategy to set up.
+		@param Rules rules:			Rules to play. Pools of up to SEARCH_MAX_POOL sticks.
+		@param long long budget_ns:	Time per pick. 0: until proven, or SEARCH_MAX_DEPTH plies.
+		@param uint64_t seed:		Of the Zobrist keys.
+		@return bool:				false if the pool is too large, or out of memory.
+	*/
+	if (!search_init(strategy, &ALPHABETA_OPS, rules, seed)) return false;
+	strategy->budget_ns = budget_ns;
+	strategy->max_depth = SEARCH_MAX_DEPTH;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool strategy_human(Strategy* strategy, Rules rules, int depth, uint64_t seed) {
+	/*
+		Alpha-beta search `depth` plies deep, at random between the picks that look best. 
+		Free with `strategy_free`.
+
+		@param Strategy* strategy:	Strategy to set up.
+		@param Rules rules:			Rules to play. Pools of up to SEARCH_MAX_POOL sticks.
+		@param int depth:			Plies to look ahead. From 1 to SEARCH_MAX_DEPTH.
+		@param uint64_t seed:		Of the Zobrist keys.
+		@return bool:				false if the pool is too large, or out of memory.
+	*/
+	if (!search_init(strategy, &HUMAN_OPS, rules, seed)) return false;
+	strategy->max_depth = depth < 1 ? 1 : depth > SEARCH_MAX_DEPTH ? SEARCH_MAX_DEPTH : depth;
+	strategy->random_ties = true;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool strategy_named(Strategy* strategy, const char* name, const Solver* solver, uint64_t seed) {
+	/*
+		Sets up a strategy by name, with its defaults: `table`, `alphabeta` (SEARCH_BUDGET_NS
+		per pick) or `human` (SEARCH_HUMAN_DEPTH plies).
+
+		@param Strategy* strategy:	Strategy to set up. Free with `strategy_free`.
+		@param const char* name:	Its name.
+		@param const Solver* solver:	A built solver, of the rules to play. Not owned.
+		@param uint64_t seed:		Of the Zobrist keys.
+		@return bool:				false if there is no such strategy, or it cannot be set up.
+	*/
+	if (!strcmp(name, TABLE_OPS.name)) {
+		strategy_table(strategy, solver);
+		return true;
+	}
+	if (!strcmp(name, ALPHABETA_OPS.name)) 
+		return strategy_alphabeta(strategy, solver->rules, SEARCH_BUDGET_NS, seed);
+	if (!strcmp(name, HUMAN_OPS.name)) 
+		return strategy_human(strategy, solver->rules, SEARCH_HUMAN_DEPTH, seed);
+	return false;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny strategy_pick(Strategy* strategy, long long remaining, tiny last, Rng* rng) {
+	/*
+		@param Strategy* strategy:	A set up strategy.
+		@param long long remaining:		Sticks left. 0 to `rules.pool`.
+		@param tiny last:			What the other player just picked, 0 if nothing. 
+									Only `retro` needs it, for variants that bar repeats.
+		@param Rng* rng:			For the random picks. The caller's, so games replay.
+		@return tiny:				The pick, 0 if the strategy sees every pick lose.
+	*/
+	return strategy->ops->pick(strategy, remaining, last, rng);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void strategy_free(Strategy* strategy) {
+	/*
+		@param Strategy* strategy:	Strategy whose tables to free.
+	*/
+	if (strategy->ops && strategy->ops->free) strategy->ops->free(strategy);
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Logic                                   //
+// ------------------------------------------------------------------------------------ //
+
+tiny random_pick(Session* session, tiny choice_sum) {
+	/*
+		A random legal choice. This is how normies are played against.
+
+		@param Session* session:	The game being played.
+		@param tiny choice_sum:	Current Sum of all choices made by both players.
+		@return tiny:			Random choice between 1 and the sticks left (at most 4).
+	*/
+	return random_move(&session->solver.rules, session->solver.rules.pool - choice_sum, 
+		rng_next(&session->rng));
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static tiny best_pick(Session* session, tiny choice_sum, tiny last) {
+	/*
+		The pick of the session's strategy. The solver's, unless the caller set up another.
+
+		@return tiny:	Choice that leaves a losing position, 0 if there is none.
+	*/
+	long long remaining = session->solver.rules.pool - choice_sum;
+	return strategy_pick(&session->strategy, remaining, last, &session->rng);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny computer_pick(Session* session, tiny choice_sum, tiny last) {
+	/*
+		Algorithm for the best possible choice. Pure game logic: no I/O, no REFUSE.
+		Whatever the session's `Strategy` picks: by default a lookup in the table 
+		`solver_init` built at startup.
+
+		@param Session* session:	The game being played.
+		@param tiny choice_sum:	Current Sum of all choices made by both players.
+		@param tiny last:		The player's last choice, 0 if the computer goes first.
+		@return tiny:			Choice that leaves a losing position, 0 if there is none.
+	*/
+	if (!session->metrics.enabled) return best_pick(session, choice_sum, last);
+
+	Metrics* metrics = &session->metrics;
+	long long start = monotonic_ns();
+	tiny pick = best_pick(session, choice_sum, last);
+	long long spent = monotonic_ns() - start;
+	metrics->computer_picks++;
+	metrics->computer_ns += spent;
+	if (spent > metrics->computer_max_ns) metrics->computer_max_ns = spent;
+	return pick;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                Subsection: Game Flow                                 //
+// ------------------------------------------------------------------------------------ //
+/*
+	The game, from the greeting to the goodbye, is a state machine: a `Flow`. 
+	`flow_step` draws into the session's frame until the game has to wait, and returns
+	what for: the player's next choice (STEP_INPUT), a pause (STEP_WAIT) or nothing
+	more (STEP_END). Whoever drives it shows the frame, waits, and steps again:
+		- `session_run`, blocking on its terminal (`getn`, `pause_frame`).
+		- The server, for thousands of players on one thread. It keeps a Flow per player
+		  and steps them all on one shared session.
+	Nothing lives on the call stack between two steps. Each state is one stretch of the
+	old straight-line game between two waits, and draws the same bytes.
+
+	Animations are states too. `flow_loading` and `flow_dance` start one, which steps
+	a frame at a time and then goes on to `then`. So does FLOW_CLEAR, see `flow_clear_after`.
+	
+	REFUSE and NORMIE end the game where they are. The marker files are written there.
+*/
+
+static STEP flow_wait(Flow* flow, unsigned ms, FLOW next) {
+	/*
+		Leaves the frame on screen for `ms`, then goes on to `next`.
+	*/
+	flow->wait_ms = ms;
+	flow->state = next;
+	return STEP_WAIT;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void flow_loading(Session* session, Flow* flow, tiny nloops, const char* loading_txt, 
+		const char* dots, bool newln, FLOW then) {
+	/*
+		Starts a fake loading screen: the text, then the dots one frame at a time.
+
+		@param Session* session:	The game being played.
+		@param Flow* flow:		The flow. Goes on to `then` once the dots are done.
+		@param tiny nloops:		How many times to show the dots / ellipses after deleting.
+		@param const char* loading_txt:		The text that is shown before the ellipses.
+		@param const char* dots:			The ellipses. Static: kept in the flow.
+		@param bool newln:		Whether to append newline at the end.
+		@param FLOW then:		Where to go after.
+	*/
+	flow->state = then;
+	if (!nloops) return;
+	fb_printf(session, "%s ", loading_txt);
+	flow->state = FLOW_LOADING;
+	flow->then = then;
+	flow->dots = dots;
+	flow->loops = nloops;
+	flow->at = 0;
+	flow->newln = newln;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void flow_dance(Flow* flow, const char* message, tiny nloops, FLOW then) {
+	/*
+		Starts the dance: `nloops` times every pose, under `message` (static).
+	*/
+	flow->state = FLOW_DANCE;
+	flow->then = then;
+	flow->text = message;
+	flow->loops = nloops;
+	flow->at = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static STEP flow_clear_after(Flow* flow, unsigned ms, FLOW then) {
+	/*
+		Leaves the frame on screen for `ms`, then clears it and goes on to `then`.
+	*/
+	flow->then = then;
+	return flow_wait(flow, ms, FLOW_CLEAR);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static STEP flow_wrong(Session* session, Flow* flow, bool guts, FLOW then) {
+	/* 
+		Error message shown to user when invalid option chosen. Cleared before `then`.
+
+		@param bool guts:	Whether player has guts (i.e. has chosen Impossible mode).
+	*/
+	cls(session);
+	fb_print(session, MESSAGES[guts ? invalid_choice_guts : invalid_choice]);
+	return flow_clear_after(flow, 3000, then);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void flow_mark(const char* path) {
+	/*
+		Persistence: leaves a marker file, read again by `FLOW_START` on the next run.
+
+		@param const char* path:	The marker. NULL for none.
+	*/
+	FILE* marker = path ? fopen(path, "w") : NULL;
+	if (marker) {
+		fputs("0", marker);
+		fclose(marker);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void flow_start(Flow* flow) {
+	/*
+		Sets a flow to the start of the game: the greeting, or the marker files.
+
+		@param Flow* flow:	The flow to (re)start.
+	*/
+	*flow = (Flow) {.state = FLOW_START};
+}
+
+// ------------------------------------------------------------------------------------ //
+
+STEP flow_step(Session* session, Flow* flow, tiny choice) {
+	/*
+		Runs the game until it has to wait. The frame is left for the caller to show.
+
+		@param Session* session:	Draws the frame. Its rng, game and screen belong to the flow.
+		@param Flow* flow:		Where the game is. Moved on to where it waits next.
+		@param tiny choice:		The player's answer, as `getn` reads it, if the last step
+								returned STEP_INPUT. Ignored otherwise.
+		@return STEP:			What to wait for before the next step.
+	*/
+	const FG_COLOR computer_color = FG_CYAN;
+	FG_COLOR player_color = FG_RED + flow->theme;
+	const Rules* rules = &session->solver.rules; // The board, the checks and the REFUSal agree.
+	tiny pool = rules->pool; // At most BOARD_MAX_POOL.
+
+	INF_LOOP switch (flow->state) {
+		// Start. If a marker file exists, the computer will REFUSE to play, or call out a NORMIE.
+		case FLOW_START: {
+			FILE* noplay = session->noplay_path ? fopen(session->noplay_path, "r") : NULL;
+			FILE* norfile = noplay || !session->normie_path ? NULL : fopen(session->normie_path, "r");
+			if (noplay) fclose(noplay);
+			if (norfile) fclose(norfile);
+			cls(session);
+			if (noplay) return flow_wait(flow, 1000, FLOW_GET_OUT);
+			if (norfile) return flow_wait(flow, 1000, FLOW_NORMIE);
+			flow->state = FLOW_MENU;
+			break;
+		}
+		case FLOW_GET_OUT:
+			fb_puts(session, MESSAGES[get_out]);
+			return flow_clear_after(flow, 5000, FLOW_END);
+
+		// Menu. If started, greet again.
+		case FLOW_MENU:
+			fb_puts(session, MESSAGES[flow->started ? alt_greeting : greeting]);
+			flow->started = true;
+			fb_puts(session, MESSAGES[flow->normieness ? nerfed_mode_choice : mode_choice]);
+			fb_print(session, "Choice: ");
+			flow->state = FLOW_MENU_CHOICE;
+			return STEP_INPUT;
+		case FLOW_MENU_CHOICE:
+			if (choice == 1) flow->state = FLOW_NORMAL;
+			else if (choice == 2) flow->true_normie = false, flow->state = FLOW_IMPOSSIBLE;
+			else if (choice) return flow_wrong(session, flow, false, FLOW_MENU);
+			else { // Discrete
+				cls(session);
+				fb_puts(session, MESSAGES[goodbye]);
+				return flow_clear_after(flow, 5000, FLOW_END);
+			}
+			break;
+		case FLOW_CLEAR:
+			cls(session);
+			flow->state = flow->then;
+			break;
+
+		// Normal mode. Mask the bits.
+		// If player enters normal mode 5 times (despite program saying it doesn't exist)
+		// Player actually gets to play normal mode.
+		case FLOW_NORMAL:
+			if (!flow->normieness) flow->normieness = 1;
+			flow->normieness <<= 1;
+			if (flow->normieness & 0b100000) {
+				flow->normieness >>= 1; // Once a normie, always a normie.
+				flow->true_normie = true;
+				flow->state = FLOW_IMPOSSIBLE;
+				break;
+			}
+			else if (flow->normieness & 0b011100) return flow_wrong(session, flow, false, FLOW_MENU);
+
+			cls(session);
+			flow->loaded = 0;
+			flow->state = FLOW_NORMAL_LOADED;
+			break;
+		case FLOW_NORMAL_LOADED: {
+			static const struct {tiny nloops; const char *text, *dots;} loads[] = {
+				{3, "Loading Normal Mode sources", "..."},
+				{1, "Normalizing Vectors", "..."},
+				{1, "Finding Normals of all circles in sight", "..."},
+				{5, "Running Heavy (but normal) Code", "..."},
+				{1, "Almost There", "........"}
+			};
+			if (flow->loaded == sizeof(loads) / sizeof(loads[0])) {
+				return flow_wait(flow, 1000, FLOW_NORMAL_CLEARED);
+			}
+			tiny next = flow->loaded++;
+			flow_loading(session, flow, loads[next].nloops, loads[next].text, loads[next].dots, 
+				true, FLOW_NORMAL_LOADED);
+			break;
+		}
+		case FLOW_NORMAL_CLEARED:
+			cls(session);
+			return flow_wait(flow, 3000, FLOW_NORMAL_SHOWN);
+		case FLOW_NORMAL_SHOWN:
+			fb_print(session, MESSAGES[normie]);
+			return flow_clear_after(flow, 7000, FLOW_MENU);
+
+		// Impossible mode. This ensures computer always(?) wins.
+		case FLOW_IMPOSSIBLE:
+			if (flow->true_normie) {
+				fb_puts(session, MESSAGES[true_normie]);
+				return flow_wait(flow, 4000, FLOW_IMPOSSIBLE_INTRO);
+			}
+			flow->state = FLOW_IMPOSSIBLE_INTRO;
+			break;
+		case FLOW_IMPOSSIBLE_INTRO:
+			if (flow->true_normie) cls(session);
+			cls(session);
+			if (flow->true_normie) {
+				flow->state = FLOW_IMPOSSIBLE_READY;
+				break;
+			}
+			fb_puts(session, MESSAGES[guts]);
+			flow_loading(session, flow, 1, MESSAGES[loading_impossible], "......", true, 
+				FLOW_IMPOSSIBLE_GUTS);
+			break;
+		case FLOW_IMPOSSIBLE_GUTS:
+			return flow_wait(flow, 2000, FLOW_IMPOSSIBLE_READY);
+		case FLOW_IMPOSSIBLE_READY:
+			cls(session);
+			flow->state = FLOW_COLOR;
+			break;
+
+		// Player selects color.
+		case FLOW_COLOR:
+			fb_puts(session, MESSAGES[color_choice_msg]);
+			#ifdef DEBUG
+				fprintf(stderr, "HERE\n");
+			#endif
+			fb_print(session, "Choice: ");
+			flow->state = FLOW_COLOR_CHOICE;
+			return STEP_INPUT;
+		case FLOW_COLOR_CHOICE:
+			if (choice <= 0 || choice > 5) return flow_wrong(session, flow, true, FLOW_COLOR);
+			flow->theme = choice - 1;
+			flow->state = FLOW_ORDER;
+			break;
+
+		// Player order preference. Whether player or computer goes first.
+		case FLOW_ORDER:
+			fb_puts(session, getmessage(session, flow->theme, plr_pref_choice));
+			fb_print(session, "Choice: ");
+			flow->state = FLOW_ORDER_CHOICE;
+			return STEP_INPUT;
+		case FLOW_ORDER_CHOICE: {
+			bool start_with_computer = choice - 1; // Anything but 1: the computer goes first.
+			flow->board = board_new(start_with_computer ? COMPUTER : HUMAN);
+			if (flow->true_normie) {
+				flow->state = FLOW_DEAL;
+				break;
+			}
+			fb_puts(session, MESSAGES[start_with_computer ? bad_choice : good_choice]);
+			return flow_wait(flow, 2000, FLOW_DEAL);
+		}
+
+		// Every game gets a seed of its own, so a recorded game can be played again.
+		case FLOW_DEAL:
+			session->game = (ReplayGame) {
+				.theme = flow->theme, .first = board_turn(flow->board), 
+				.normie = flow->true_normie, .seeded = true, .seed = rng_next(&session->rng)
+			};
+			rng_seed(&session->rng, session->game.seed);
+			flow->state = FLOW_TURN;
+			break;
+		case FLOW_TURN:
+			if (board_taken(flow->board) >= pool) flow->state = FLOW_OVER;
+			else flow->state = board_turn(flow->board) == HUMAN ? FLOW_HUMAN : FLOW_COMPUTER;
+			break;
+
+		// Get player choice.
+		case FLOW_HUMAN: {
+			tiny remaining = pool - board_taken(flow->board);
+			draw_board(session, flow->board, pool, player_color, computer_color); // Only what changed.
+			fb_puts(session, "");
+
+			// Prompt w/ valid choices: up to the largest that still fits.
+			uint64_t legal = legal_moves(rules, remaining);
+			tiny most = legal ? highest_bit(legal) + 1 : 0;
+			if (most == 3) fb_puts(session, getmessage(session, flow->theme, plr_choice_3));
+			else if (most == 2) fb_puts(session, getmessage(session, flow->theme, plr_choice_2));
+			else if (most == 1) fb_puts(session, getmessage(session, flow->theme, plr_choice_1));
+			else fb_puts(session, getmessage(session, flow->theme, plr_choice_4));
+
+			fb_print(session, "Choice: ");
+			flow->state = FLOW_HUMAN_CHOICE;
+			return STEP_INPUT;
+		}
+		case FLOW_HUMAN_CHOICE:
+			if (choice <= 0 || choice > 64 
+					|| !(legal_moves(rules, pool - board_taken(flow->board)) >> (choice - 1) & 1)) {
+				return flow_wrong(session, flow, true, FLOW_HUMAN_RETRY);
+			}
+			flow->board = board_apply(flow->board, choice); // Also switches Player.
+			if (session->record) replay_push(session->record, choice);
+			flow->state = FLOW_TURN;
+			break;
+		case FLOW_HUMAN_RETRY:
+			cls(session);
+			flow->state = FLOW_HUMAN;
+			break;
+
+		// Computer's turn: `computer_pick`, with the taunts and the REFUSal. Random for normies.
+		case FLOW_COMPUTER: {
+			tiny choice_sum = board_taken(flow->board);
+			draw_board(session, flow->board, pool, player_color, computer_color);
+			fb_puts(session, "");
+			fb_print(session, getmessage(session, flow->theme, cmp_choice));
+
+			if (flow->true_normie) flow->pick = random_pick(session, choice_sum);
+			else if (forced_last(rules, rules->pool - choice_sum)) { // About to lose.
+				flow->state = FLOW_REFUSE;
+				break;
+			}
+			else if ((flow->pick = computer_pick(session, choice_sum, board_last(flow->board)))) fb_print(session, MESSAGES[emj_evil]);
+			else {
+				fb_print(session, MESSAGES[emj_angry]);
+				flow->pick = random_pick(session, choice_sum);
+			}
+
+			fb_puts(session, "");
+			flow_loading(session, flow, 1, MESSAGES[cmp_ichoose], ".....", false, FLOW_COMPUTER_PICKED);
+			break;
+		}
+		case FLOW_COMPUTER_PICKED: {
+			// Colored straight into a stack buffer. No allocation.
+			char digit[2] = {'0' + flow->pick, 0}, pick[40];
+			strnice_into(session, pick, sizeof(pick), digit, computer_color, BG_DEFAULT, modheavy, 1);
+			fb_printf(session, " %s", pick);
+
+			// Hide the user input.
+			fb_printf(session, "\nPress Enter to continue...\033[%hdm", HIDE);
+			flow->state = FLOW_COMPUTER_SEEN;
+			return STEP_INPUT; // FLUSH
+		}
+		case FLOW_COMPUTER_SEEN:
+			fb_puts(session, "\033[0m");
+			flow->board = board_apply(flow->board, flow->pick); // Also switches Player.
+			if (session->record) replay_push(session->record, flow->pick);
+
+			// We are creating strings here; good idea to GC. 
+			_gc(session);
+			flow->state = FLOW_TURN;
+			break;
+
+		// Whoever is left to move did not pick the last stick.
+		case FLOW_OVER:
+			session->game.winner = board_turn(flow->board);
+			if (session->record) replay_end(session->record, &session->game);
+			if (session->game.winner == COMPUTER) flow_dance(flow, MESSAGES[dance_msg], 3, FLOW_OVER_DANCED);
+			else flow_loading(session, flow, 1, MESSAGES[true_normie_win], "..........", true, FLOW_OVER_WON);
+			break;
+		case FLOW_OVER_DANCED: // Computer has won!
+			fb_puts(session, MESSAGES[replay]);
+			flow_loading(session, flow, 1, "Resetting", "...", true, FLOW_OVER_RESET);
+			break;
+		case FLOW_OVER_RESET:
+			_gc(session);
+			cls(session);
+			flow->state = FLOW_MENU;
+			break;
+		case FLOW_OVER_WON:
+			cls(session);
+			return flow_wait(flow, 1000, FLOW_OVER_LOSS);
+		case FLOW_OVER_LOSS:
+			fb_puts(session, MESSAGES[true_normie_loss]);
+			return flow_wait(flow, 2000, FLOW_NORMIE);
+
+		// REFUSE to play with the player.
+		case FLOW_REFUSE:
+			fb_puts(session, "");
+			flow_loading(session, flow, 1, strnice(session, "no", FG_RED, BG_DEFAULT, modheavy, 1), 
+				".....", true, FLOW_REFUSE_NO);
+			break;
+		case FLOW_REFUSE_NO:
+			return flow_wait(flow, 1000, FLOW_REFUSE_CAPS);
+		case FLOW_REFUSE_CAPS:
+			flow_loading(session, flow, 1, strnice(session, "NO", FG_RED, BG_DEFAULT, modheavy, 1), 
+				"..........", true, FLOW_REFUSE_CAPS_DONE);
+			break;
+		case FLOW_REFUSE_CAPS_DONE:
+			return flow_wait(flow, 1000, FLOW_REFUSE_MAX);
+		case FLOW_REFUSE_MAX: {
+			char* no_max = strnice(session, "NO!  ", FG_RED, BG_DEFAULT, modheavy, 1);
+			for (unsigned short n = 10000; n--;) {
+				fb_print(session, no_max);
+			};
+			fb_puts(session, "");
+
+			if (session->record) {
+				session->game.refused = true;
+				session->game.winner = HUMAN;
+				replay_end(session->record, &session->game);
+			}
+
+			// This enables us to REFUSE whenever player has won once.
+			flow_mark(session->noplay_path);
+			cls(session);
+			flow->state = FLOW_END;
+			break;
+		}
+
+		// Callout the NORMIE!!
+		case FLOW_NORMIE:
+			flow_loading(session, flow, 1, "You, you are a ", MESSAGES[normie_max], true, FLOW_NORMIE_MAX);
+			break;
+		case FLOW_NORMIE_MAX:
+			for (unsigned short n = 10000; n--;) {
+				fb_print(session, MESSAGES[normie_max]);
+			};
+			fb_puts(session, "");
+			flow_mark(session->normie_path);
+			cls(session);
+			flow->state = FLOW_END;
+			break;
+
+		// Animations. One frame per step.
+		case FLOW_LOADING: {
+			tiny ndots = strlen(flow->dots);
+			while (flow->loops) {
+				while (flow->at < ndots) {
+					char load = flow->dots[flow->at++];
+					fb_putc(session, load);
+					#ifndef DEBUG
+						if (load == '.' || (load >= 'A' && load <= 'z')) {
+							return flow_wait(flow, session->clock.frame_ms, FLOW_LOADING);
+						}
+					#endif
+				}
+
+				// ANSI Escape codes to move cursor.
+				// nD = Move n to the left. 0K = Delete from cursor to end of screen.	
+				flow->at = 0;
+				if (--flow->loops) fb_printf(session, "\033[%hdD\033[0K", ndots); 
+			}
+			if (flow->newln) fb_putc(session, '\n');
+			flow->state = flow->then;
+			break;
+		}
+		case FLOW_DANCE:
+			if (!flow->loops) {
+				flow->state = flow->then;
+				break;
+			}
+			if (flow->at == nDANCES) {
+				cls(session);
+				flow->loops--;
+				flow->at = 0;
+				break;
+			}
+			cls(session);
+			fb_puts(session, flow->text);
+			fb_puts(session, DANCES[(unsigned char) flow->at++]);
+			return flow_wait(flow, session->clock.frame_ms, FLOW_DANCE);
+
+		case FLOW_END:
+			return STEP_END;
+	}
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                 Subsection: Session                                  //
+// ------------------------------------------------------------------------------------ //
+
+void session_init(Session* session, FILE* in, FILE* out) {
+	/*
+		Prepares a session to play on the given streams. Cheap: the arenas and the 
+		colored messages are only allocated once the game needs them.
+		Callers may change the clock, the marker paths and the seed before `session_run`.
+		The seed defaults to the time, mixed with the session's address so that sessions
+		started together still play differently.
+
+		@param Session* session:	Session to initialize.
+		@param FILE* in:			Where the player's choices are read from.
+		@param FILE* out:			Where the game is drawn.
+									Either may be NULL if the caller sets `in_fd` / `out_fd`.
+	*/
+	*session = (Session) {
+		.in = in,
+		.out = out,
+		.in_fd = in ? fileno(in) : -1,
+		.out_fd = out ? fileno(out) : -1,
+		.noplay_path = "./noplay",
+		.normie_path = "./normie",
+		.clock = {.mode = CLK_REAL, .frame_ms = FRAME_MS},
+		.sgr = {.enabled = true}
+	};
+	arena_init(&session->frame_arena, FRAME_ARENA_SIZE);
+	arena_init(&session->theme_arena, THEME_ARENA_SIZE);
+	solver_init(&session->solver, CLASSIC_RULES);
+	strategy_table(&session->strategy, &session->solver);
+	rng_seed(&session->rng, monotonic_ns() ^ (uintptr_t) session);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void session_run(Session* session) {
+	/*
+		Plays the game, from the greeting to the goodbye: steps its `Flow`, showing each
+		frame and waiting as it asks. Ends early if the computer REFUSEs, calls out a 
+		NORMIE, or the player's input is gone.
+		A terminal is in raw mode meanwhile, and put back as it was after.
+		The metrics are dumped to `metrics.out` at the end, if set.
+
+		@param Session* session:	An initialized session.
+	*/
+	Flow flow;
+	tiny choice = -1;
+	flow_start(&flow);
+	input_raw(session);
+	INF_LOOP {
+		metrics_poll(session);
+		STEP step = flow_step(session, &flow, choice);
+		if (step == STEP_END) break;
+		if (step == STEP_WAIT) pause_frame(session, flow.wait_ms);
+		else if ((choice = getn(session)) < 0 && session->input.eof && !session->input.npending) break;
+	}
+	input_restore(session);
+
+	if (session->metrics.out) {
+		fb_flush(session); // The goodbye counts.
+		metrics_dump(session, session->metrics.out);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void session_free(Session* session) {
+	/*
+		Shows the last frame and releases everything the session holds.
+
+		@param Session* session:	Session to free. Can be initialized again.
+	*/
+	_gc_full_(session);
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                Subsection: Simulation                                //
+// ------------------------------------------------------------------------------------ //
+/*
+	Headless mode. Plays the game logic with no terminal at all: no `cls`, waits,
+	loading screens or dances. Used to regression-test and load-test the engine.
+
+	Usage:
+		game.bin --simulate N [--human BOT] [--computer BOT] 
+		                      [--first human|computer|alternate] [--seed S]
+		                      [--pool N] [--moves 1,3,4] [--normal] [--record FILE]
+	
+	BOT is `optimal`, `random`, or a script of picks such as `4321`.
+	The rules default to the game's own: 21 sticks, picks 1-4, misere play.
+*/
+
+bool parse_seat(Seat* seat, const char* arg) {
+	/*
+		Reads a BOT from the command line.
+
+		@param Seat* seat:		Seat to fill in.
+		@param const char* arg:	`optimal`, `random` or a script of digits 1-9.
+		@return bool:			Whether the argument was valid.
+	*/
+	*seat = (Seat) {0};
+	if (!strcmp(arg, "optimal")) seat->bot = BOT_OPTIMAL;
+	else if (!strcmp(arg, "random")) seat->bot = BOT_RANDOM;
+	else {
+		for (const char* c = arg; *c; c++) if (*c < '1' || *c > '9') return false;
+		if (!*arg) return false;
+		seat->bot = BOT_SCRIPT;
+		seat->script = arg;
+		seat->nscript = strlen(arg);
+	}
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool parse_moves(uint64_t* moves, const char* arg) {
+	/*
+		Reads a set of allowed picks from the command line.
+
+		@param uint64_t* moves:		Set to fill in. Bit s-1 for pick s.
+		@param const char* arg:		Comma separated picks, like `1,3,4`. Each 1 to 64.
+		@return bool:				Whether the argument was valid.
+	*/
+	*moves = 0;
+	while (*arg) {
+		char* end;
+		long pick = strtol(arg, &end, 10);
+		if (end == arg || pick < 1 || pick > 64 || (*end && *end != ',')) return false;
+		*moves |= 1ULL << (pick - 1);
+		arg = *end ? end + 1 : end;
+	}
+	return *moves != 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+tiny seat_pick(const Solver* solver, Rng* rng, const Seat* seat, const Rules* rules, 
+		long long remaining, long nmove) {
+	/*
+		Gets the next pick of whichever BOT sits in the seat.
+
+		@param const Solver* solver:	The game solved, for BOT_OPTIMAL.
+		@param Rng* rng:				Generator for BOT_RANDOM.
+		@param const Seat* seat:		The seat to play.
+		@param const Rules* rules:		Rules of the game.
+		@param long long remaining:		Sticks left in the pool.
+		@param long nmove:				How many picks this seat already made this game.
+		@return tiny:					A legal pick. There must be one.
+	*/
+	uint64_t legal = legal_moves(rules, remaining), below;
+	tiny choice;
+
+	switch (seat->bot) {
+		case BOT_OPTIMAL:
+			choice = solver_move(solver, remaining);
+			// Same fallback as the computer in `FLOW_COMPUTER`. The computer seat REFUSEs earlier.
+			return choice ? choice : random_move(rules, remaining, rng_next(rng));
+		case BOT_RANDOM:
+			return random_move(rules, remaining, rng_next(rng));
+		case BOT_SCRIPT:
+			choice = seat->script[nmove % seat->nscript] - '0';
+			// A scripted player who asks for an illegal pick retries with the closest
+			// smaller legal one, or the smallest legal one if there is none.
+			below = legal & ((2ULL << (choice - 1)) - 1);
+			if (below) return highest_bit(below) + 1;
+			choice = 1;
+			while (!(legal & 1)) legal >>= 1, choice++;
+			return choice;
+	}
+	return 1;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+PLAYER simulate_game(const Solver* solver, Rng* rng, const SimConfig* cfg, PLAYER first, 
+		SimStats* stats) {
+	/*
+		Plays one game between the two seats. Same rules as impossible mode.
+
+		@param const Solver* solver:	The game solved, for BOT_OPTIMAL.
+		@param Rng* rng:				Generator for BOT_RANDOM.
+		@param const SimConfig* cfg:	Rules and the bots in each seat.
+		@param PLAYER first:			Who picks first.
+		@param SimStats* stats:			Statistics to add the game to.
+		@return PLAYER:					The winner.
+	*/
+	const Rules* rules = &cfg->rules;
+	long long remaining = rules->pool;
+	long nmoves = 0, nseat[2] = {0};
+	PLAYER currentplr = first, winner;
+	bool refused = false;
+
+	while (legal_moves(rules, remaining)) {
+		const Seat* seat = &cfg->seats[currentplr];
+
+		// The computer would rather REFUSE than pick the last stick.
+		if (currentplr == COMPUTER && seat->bot == BOT_OPTIMAL && forced_last(rules, remaining)) {
+			stats->refusals++;
+			refused = true;
+			break;
+		}
+
+		tiny choice = seat_pick(solver, rng, seat, rules, remaining, nseat[currentplr]++);
+		stats->picks[currentplr][choice]++;
+		if (cfg->record) replay_push(cfg->record, choice);
+		remaining -= choice;
+		nmoves++;
+
+		// Switch Player
+		currentplr = !currentplr;
+	}
+
+	// The player to move is stuck: the pool is empty, too small, or the computer REFUSEd.
+	// REFUSing is losing. Otherwise, as in `solver_build`: in misere play the stuck player
+	// has won, in normal play lost.
+	winner = refused ? HUMAN : rules->misere ? currentplr : !currentplr;
+
+	stats->games++;
+	stats->moves += nmoves;
+	stats->lengths[nmoves < 64 ? nmoves : 64]++;
+	stats->wins[winner]++;
+
+	if (cfg->record) {
+		ReplayGame game = {
+			.theme = REPLAY_NO_THEME, .first = first, .winner = winner, .npicks = nmoves,
+			.refused = refused, .normie = cfg->seats[COMPUTER].bot == BOT_RANDOM
+		};
+		replay_end(cfg->record, &game);
+	}
+	return winner;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+double now_seconds(void) {
+	/*
+		Wall clock time, for timing runs. `timespec_get` is standard C11.
+
+		@return double:	Seconds since the epoch, with nanosecond resolution.
+	*/
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void simulate(const Solver* solver, const SimConfig* cfg, SimStats* stats) {
+	/*
+		Plays `cfg->ngames` games back to back and times them.
+
+		@param const Solver* solver:	`cfg->rules`, solved.
+		@param const SimConfig* cfg:	What to simulate.
+		@param SimStats* stats:			Where the results go.
+	*/
+	*stats = (SimStats) {0};
+	Rng rng;
+	rng_seed(&rng, cfg->seed); // Seeded once. Reseeding per move would repeat games.
+
+	double start = now_seconds();
+	for (long n = 0; n < cfg->ngames; n++) {
+		PLAYER first = cfg->first >= 0 ? (PLAYER) cfg->first : (PLAYER) (n & 1);
+		simulate_game(solver, &rng, cfg, first, stats);
+	}
+	stats->seconds = now_seconds() - start;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void print_simstats(const SimConfig* cfg, const SimStats* stats) {
+	/*
+		Prints aggregate results. Plain text, one fact per line, easy to grep.
+
+		@param const SimConfig* cfg:	What was simulated.
+		@param const SimStats* stats:	The results.
+	*/
+	const char* names[2] = {"human", "computer"};
+	double games = stats->games ? stats->games : 1;
+	double secs = stats->seconds > 0 ? stats->seconds : 1e-9;
+
+	printf("games:           %ld\n", stats->games);
+	printf("seed:            %llu\n", (unsigned long long) cfg->seed);
+	printf("rules:           pool %lld, picks", cfg->rules.pool);
+	for (tiny s = 1; s <= 64; s++) if (cfg->rules.moves >> (s - 1) & 1) printf(" %d", s);
+	printf(", %s play\n", cfg->rules.misere ? "misere" : "normal");
+	printf("seconds:         %.3f\n", stats->seconds);
+	printf("games/sec:       %.0f\n", stats->games / secs);
+	printf("moves/sec:       %.0f\n", stats->moves / secs);
+	printf("avg moves/game:  %.2f\n", stats->moves / games);
+	for (tiny p = HUMAN; p <= COMPUTER; p++) {
+		printf("%-8s wins:  %ld (%.2f%%)\n", names[p], stats->wins[p], 100 * stats->wins[p] / games);
+		printf("%-8s picks:", names[p]);
+		for (tiny s = 1; s <= 64; s++) if (stats->picks[p][s]) printf(" %d:%ld", s, stats->picks[p][s]);
+		puts("");
+	}
+	printf("refusals:        %ld\n", stats->refusals);
+	printf("game lengths:   ");
+	for (tiny n = 0; n < 64; n++) if (stats->lengths[n]) printf(" %d:%ld", n, stats->lengths[n]);
+	if (stats->lengths[64]) printf(" 64+:%ld", stats->lengths[64]);
+	puts("");
+}
@@ -0,0 +1,951 @@
+// ==================================================================================== //
+//                                21 Matchsticks: Engine                                //
+// ==================================================================================== //
+/*!
+	libmatchsticks. The whole game, minus `main`.
+
+	Every bit of state a game needs lives in a `Session`, passed to each function
+	that needs it. The only globals are read-only tables, so a process can run any 
+	number of games at once, on any number of threads.
+
+	Usage:
+		Session session;
+		session_init(&session, stdin, stdout);
+		session_run(&session);
+		session_free(&session);
+!*/
+
+#ifndef MATCHSTICKS_H
+#define MATCHSTICKS_H
+
+// ==================================================================================== //
+//                                   Translation Unit                                   //
+// ==================================================================================== //
+
+#include <stdio.h>		// FILE, printf, fprintf, fopen, fclose, stderr
+#include <stdlib.h>		// malloc, free, exit
+#include <stddef.h>		// size_t, max_align_t
+#include <stdarg.h>		// va_list, va_arg, va_start, va_end
+#include <stdbool.h>	// bool, true, false.
+#include <stdint.h>		// uint64_t
+#include <signal.h>		// sig_atomic_t. See `Metrics`.
+#include <stdatomic.h>	// atomic_llong. See `RetroJob`.
+
+#ifndef _WIN32
+	#include <termios.h>	// struct termios. See `Input`.
+#endif
+
+#ifdef _WIN32
+	#define itoa itoa_ // Apparently x86_64-w64-migw32-gcc's stdlib CONTAINS itoa...
+#endif
+
+// ------------------------------------------------------------------------------------ //
+
+// Macros
+#define R(str) #str // Get the stringized value. Basically, load the rawstring.
+#define INF_LOOP while(1)
+
+// Preprocessor-level Constants
+#define nMSG 34
+#define nDANCES 8
+#define nTHEMES 5
+#define nTHEMED (cmp_choice - plr_pref_choice + 1) // Messages that depend on the THEME.
+#define THEMED(idx) ((idx) - plr_pref_choice) // Index of a MESSAGE_IDX in `Theme.messages`.
+
+// Virtual clock. See `Subsection: Clock`.
+#define FRAME_MS 1000			// Default length of one animation step.
+#define CLOCK_FAST_SPEEDUP 20	// How much faster CLK_FAST runs than real time.
+
+// Longest period `solver_init` looks for before giving up and storing every position.
+#define SOLVER_MAX_PERIOD (1LL << 26)
+
+// Interned SGR escape prefixes. Must be a power of 2. See `sgr_prefix`.
+#define SGR_CACHE_BITS 9
+#define SGR_CACHE_SIZE (1 << SGR_CACHE_BITS)
+
+// Packs a style into a key: 7 bits of fg, 7 of bg, 10 for the MODIFIER set.
+#define SGR_KEY(fg, bg, modset) ((uint32_t) (fg) | (uint32_t) (bg) << 7 | (uint32_t) (modset) << 14)
+
+// Layout of a Board. See `Subsection: Board`.
+#define BOARD_MAX_POOL 56							// Sticks the history has room for.
+#define BOARD_HISTORY ((1ULL << BOARD_MAX_POOL) - 1)	// Bit i: who took the i-th stick.
+#define BOARD_TAKEN_SHIFT 56						// Bits 56-61: sticks taken so far.
+#define BOARD_TURN (1ULL << 63)						// Set if it is the computer's turn.
+
+// Longest escape sequence `sgr_filter` holds back when a frame ends in the middle of one.
+#define SGR_PARTIAL_SIZE 32
+
+// Keys read ahead of `getn`, while an animation plays. See `Subsection: Input`.
+#define INPUT_PENDING_SIZE 16
+
+// Stick segments kept ready to draw, per owner: picks of 1 to SCREEN_SEGMENTS - 1 sticks.
+#define SCREEN_SEGMENTS 8
+#define SCREEN_SEGMENT_SIZE 32
+
+// Replay logs. See `Subsection: Replay`.
+#define REPLAY_MAGIC "21MR"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 24		// Bytes before the first record.
+#define REPLAY_NO_THEME 7			// Theme of games between bots.
+
+// Endgame tables of games of several heaps. See `Subsection: Tablebase`.
+#define TABLEBASE_MAGIC "21MT"
+#define TABLEBASE_VERSION 1
+#define TABLEBASE_HEADER_SIZE 32	// Bytes before the first entry.
+#define TABLEBASE_MAX_HEAPS 8
+#define TABLEBASE_MAX_STICKS 65535	// Across all heaps. Distances fit in 2 bytes.
+#define TABLEBASE_MAX_POSITIONS (1LL << 34)
+
+// Retrograde solver. See `Subsection: Retrograde`.
+#define MAX_THREADS 256		// Most threads of a solve (and of the tournament).
+#define RETRO_WON 0xFE		// Counters at RETRO_WON and above are solved states.
+#define RETRO_LOST 0xFF
+#define RETRO_BATCH 256		// Solved states a thread pushes to the frontier at a time.
+#define RETRO_CLAIM 64		// Most states a thread takes from the frontier at a time.
+
+// Strategies of the computer. See `Subsection: Strategies`.
+#define SEARCH_MAX_POOL (1 << 22)		// Zobrist keys are drawn for every pile up to this.
+#define SEARCH_TT_BITS 16				// Transposition table of 2^16 entries, 1 MB.
+#define SEARCH_BUDGET_NS 10000000LL		// Time per pick of `alphabeta`: 10 ms.
+#define SEARCH_HUMAN_DEPTH 4			// Plies `human` looks ahead.
+#define SEARCH_WIN (1 << 30)			// Score of a won position. Won in k plies: SEARCH_WIN - k.
+#define SEARCH_PROVEN (SEARCH_WIN - SEARCH_MAX_POOL - 1) // Scores past this are proven.
+#define SEARCH_EXACT INT16_MAX			// Depth of a proven entry: good at any depth.
+#define SEARCH_MAX_DEPTH (SEARCH_EXACT - 1) // Deepest search, so depths stay apart from SEARCH_EXACT.
+
+// Buckets of the key to frame latency histogram. Bucket b: under 2^b microseconds. 
+// The last holds the rest. See `Metrics`.
+#define METRICS_LATENCY_BUCKETS 24
+
+// Arena sizes. Both grow on demand, these are just the first blocks.
+#define FRAME_ARENA_SIZE 4096
+#define THEME_ARENA_SIZE 1024
+
+// ==================================================================================== //
+//                                        Types                                         //
+// ==================================================================================== //
+
+// `char` is also a numeric type and for our purposes, it will save memory.
+typedef char tiny; 
+
+typedef enum {
+	HUMAN = 0,
+	COMPUTER = 1
+} PLAYER;
+
+// These make it easy to find the correct messages, instead of remembering magic values.
+// Also makes alterations handled well.
+typedef enum {
+	// 7
+	emj_smile,
+	emj_happy,
+	emj_angry,
+	emj_evil,
+	emj_taunt,
+	emj_sad,
+	emj_cry,
+
+	// 5
+	greeting,
+	alt_greeting,
+	mode_choice,
+	nerfed_mode_choice,
+	color_choice_msg,
+
+	// 4
+	goodbye,
+	normie,
+	guts,
+	true_normie,
+
+	// 5
+	invalid_choice,
+	invalid_choice_guts,
+	good_choice,
+	bad_choice,
+	get_out,
+
+	// 6
+	plr_pref_choice,
+	plr_choice_4,
+	plr_choice_3,
+	plr_choice_2,
+	plr_choice_1,
+	cmp_choice,
+
+	// 5
+	dance_msg,
+	replay,
+	true_normie_win,
+	true_normie_loss,
+	normie_max,
+
+	// 2
+	loading_impossible,
+	cmp_ichoose
+		
+} MESSAGE_IDX ;
+
+// Player colors. Each has its own set of colored messages, see `getmessage`.
+typedef enum {
+	THEME_RED = 0,
+	THEME_GREEN = 1,
+	THEME_YELLOW = 2,
+	THEME_BLUE = 3,
+	THEME_PURPLE = 4
+} THEME;
+
+// ------------------------------------------------------------------------------------ //
+
+// One contiguous block of an arena. When an arena runs out of space, a new block is
+// chained after the current one instead of writing past the end.
+typedef struct ArenaBlock {
+	struct ArenaBlock* next;
+	size_t cap, used;
+	max_align_t data[]; // Flexible array member. max_align_t keeps the data aligned.
+} ArenaBlock;
+
+// Bump allocator. Allocation is a pointer increment; reset rewinds to the first block
+// without freeing anything, so blocks are reused for the next frame / game.
+typedef struct {
+	ArenaBlock *head, *cur;
+	size_t nalloc, bytes;		// Allocations & bytes since last reset.
+	size_t peak_bytes;			// Highest `bytes` ever seen between two resets.
+	size_t total_allocs;		// Allocations over the lifetime of the arena.
+	size_t total_bytes;			// Bytes over the lifetime of the arena.
+	size_t nblocks, capacity;	// Blocks chained & their summed capacity.
+	size_t nresets;
+	size_t block_size;			// Size of the first block, allocated on first use.
+} Arena;
+
+// ------------------------------------------------------------------------------------ //
+
+// Output buffer for the terminal. Everything drawn goes here first, and the whole frame
+// is written with one syscall when the program is about to wait (see `fb_flush`).
+typedef struct {
+	char* buf;
+	size_t len, cap;
+	size_t frames, bytes, syscalls;			// Totals since startup.
+	size_t frame_bytes, frame_syscalls;		// Of the last frame written.
+} Frame;
+
+// ------------------------------------------------------------------------------------ //
+
+// Text style of the terminal, as far as SGR (`\033[...m`) goes.
+typedef struct {
+	uint8_t fg, bg;		// SGR color codes. 0 is the default color.
+	uint16_t mods;		// Bit m set: MODIFIER m is on.
+	bool opaque;		// Set by codes the filter does not model (256 / RGB colors).
+} SgrState;
+
+// Output stage that drops redundant SGR sequences. It follows the style the text asks 
+// for and the style the terminal is in, and only emits the difference, right before
+// something is printed with it. See `Subsection: SGR Filter`.
+typedef struct {
+	bool enabled;
+	SgrState term, want;
+	char* out;			// Filtered frame. Grows like the frame buffer.
+	size_t cap;
+	char partial[SGR_PARTIAL_SIZE]; // An escape sequence cut short by the end of a frame.
+	tiny npartial;
+	size_t bytes_in, bytes_out;
+} SgrFilter;
+
+// ------------------------------------------------------------------------------------ //
+
+// How waits are carried out. The game is drawn the same in every mode.
+typedef enum {
+	CLK_REAL = 0,		// Waits take as long as they say.
+	CLK_FAST = 1,		// Waits are `CLOCK_FAST_SPEEDUP` times shorter.
+	CLK_INSTANT = 2		// Nothing waits. Time is only counted. For tests and recordings.
+} CLOCK_MODE;
+
+// Schedules the waits between frames. Each wait ends at an absolute deadline, so the
+// time spent drawing a frame is taken out of the wait instead of adding up.
+typedef struct {
+	CLOCK_MODE mode;
+	unsigned frame_ms;		// One animation step: a loading dot, a dance pose.
+	long long deadline;		// Monotonic ns at which the last wait was due to end.
+	long long virtual_ns;	// Game time passed in waits, the same in every mode.
+	long long slept_ns;		// Real time actually spent waiting.
+	size_t nwaits;
+} Clock;
+
+// ------------------------------------------------------------------------------------ //
+
+// Keys from the player. On a terminal, `session_run` switches it to raw mode: every key
+// arrives as it is pressed, no Enter needed, and waits wake up on it, so a key cuts the 
+// animation short. Pipes and files are read a line at a time, as before. 
+// See `Subsection: Input`.
+typedef struct {
+	bool raw;					// Set while the terminal is in raw mode.
+	bool eof;					// The input is gone. Waits stop looking at it, `session_run` ends.
+	bool skip;					// A key came during a wait. No more waits until `getn`.
+	char pending[INPUT_PENDING_SIZE]; // Keys read, not yet taken by `getn`.
+	tiny npending;
+	long long key_ns;			// When the last key was read. 0 once a frame answered it.
+	size_t keys, skips, nanswered;
+	long long latency_ns, max_latency_ns; // From a key to the frame that answers it.
+	#ifndef _WIN32
+		struct termios saved;	// Put back by `input_restore`.
+	#endif
+} Input;
+
+// ------------------------------------------------------------------------------------ //
+
+// String helpers whose allocations `Metrics` counts.
+typedef enum {
+	HELPER_ITOA = 0,
+	HELPER_JOINSTR,		// `arena_joinstr`, joining the colored messages of a theme.
+	HELPER_EMOJIFY,
+	HELPER_STRNICE,
+	nHELPERS
+} HELPER;
+
+// What the game spent, dumped as JSON by `metrics_dump`. Frames, writes and keys are 
+// counted anyway, in `Frame` and `Input`. The rest is only counted once `enabled` is set:
+// until then it costs one branch per helper call. See `Subsection: Metrics`.
+typedef struct {
+	bool enabled;
+	FILE* out;					// If not NULL, `session_run` dumps to it when the game ends.
+	volatile sig_atomic_t dump;	// Set (by a signal handler, say) to dump to `out` at once.
+	size_t allocs[nHELPERS], bytes[nHELPERS];
+	size_t computer_picks;
+	long long computer_ns, computer_max_ns;		// Spent in `computer_pick`.
+	size_t latency[METRICS_LATENCY_BUCKETS];	// Key to frame. See METRICS_LATENCY_BUCKETS.
+} Metrics;
+
+// ------------------------------------------------------------------------------------ //
+
+// Rules of a subtraction game. The game itself is {21, picks 1-4, misere}.
+typedef struct {
+	long long pool;		// Sticks in the pool at the start.
+	uint64_t moves;		// Bit s-1 set means a player may pick s sticks. 1 <= s <= 64.
+	bool misere;		// Whether the player to pick the last stick loses.
+} Rules;
+
+// A game of up to BOARD_MAX_POOL sticks in one word: who is to move, how many sticks 
+// are gone and who took each of them. Picks alternate, so every run of sticks taken
+// by the same player is one pick and the whole game can be read back (or undone).
+// Copied, compared and hashed like any integer. See `Subsection: Board`.
+typedef uint64_t Board;
+
+// ------------------------------------------------------------------------------------ //
+
+// Win / loss table of a subtraction game, built once by `solver_init`.
+// Only positions below `nbits` are stored. Past that, the table repeats every `period`
+// positions from `start` on, so any pool size is answered from the stored part.
+typedef struct {
+	Rules rules;
+	uint64_t* losing;	// Bitset. Bit n is set if the player to move with n sticks loses.
+	uint64_t revmoves;	// `rules.moves` mirrored: bit 64-s set means s may be picked.
+	long long nbits, nwords;
+	long long start, period; // Period 0: not periodic (or not looked for), all stored.
+} Solver;
+
+// ------------------------------------------------------------------------------------ //
+
+// Distance to the end of every position of a game of several heaps, under one set of
+// `Rules`: a move picks from one heap. Built once with `tablebase_build`, then saved and
+// memory-mapped read-only by every process that plays it. See `Subsection: Tablebase`.
+typedef struct {
+	const uint8_t* data;	// The whole file. Entries start at TABLEBASE_HEADER_SIZE.
+	size_t size;
+	Rules rules;			// `pool`: the largest heap.
+	tiny nheaps;
+	tiny entry_bytes;		// 1, or 2 once distances can pass 255.
+	long long npositions;
+	bool mapped;			// false if built here, or read into memory instead.
+} Tablebase;
+
+// ------------------------------------------------------------------------------------ //
+
+// Grundy values of the piles of a subtraction game, to play sums of piles: a position
+// is decided by the XOR of its piles' values, corrected for misere play. 
+// See `Subsection: Grundy`.
+typedef struct {
+	Rules rules;			// `pool`: the largest pile.
+	uint8_t* values;		// Normal play value of each pile, 0 to `rules.pool`.
+	uint8_t* misere_values;	// Misere play value of each. NULL in normal play.
+	tiny max_value;
+	bool tame;				// Misere sums follow from `values`. See `grundy_win`.
+} Grundy;
+
+// ------------------------------------------------------------------------------------ //
+
+// A subtraction game with no closed form: each player has picks of their own, and may be
+// barred from repeating the pick the other just made.
+typedef struct {
+	long long pool;		// Sticks in the pool at the start.
+	uint64_t moves[2];	// Picks of each PLAYER. Bit s-1 set means s sticks. 1 <= s <= 64.
+	bool misere;		// Whether the player to pick the last stick loses.
+	bool no_repeat;		// Whether a player may not pick what the other just picked.
+} Variant;
+
+// Win / loss of every state of a `Variant`: sticks left, player to move and last pick.
+// Solved backwards by `retro_solve`, on any number of threads. See `Subsection: Retrograde`.
+typedef struct {
+	Variant variant;
+	uint64_t* winning;	// Bitset. Bit i is set if the player to move in state i wins.
+	long long nstates;
+	tiny nlast;			// Last picks told apart: 0 (none) to nlast-1. 1 without `no_repeat`.
+} Retro;
+
+// One solve of `retro_solve`, shared by all its threads.
+typedef struct {
+	const Variant* variant;
+	tiny nlast;
+	long long nstates;
+	_Atomic uint8_t* counts;	// Unsolved picks of each state, or RETRO_WON / RETRO_LOST.
+	_Atomic uint64_t* queue;	// The frontier. A slot is state << 2 | 2 | won, 0 until written.
+	atomic_llong head, tail;	// Next slot to take, next slot to reserve.
+	atomic_llong done;			// Slots visited. The solve ends at `nstates`.
+	uint64_t* winning;
+	short nthreads;
+} RetroJob;
+
+// One thread of a `RetroJob`, with the states it solved but has not pushed yet.
+typedef struct {
+	RetroJob* job;
+	short id;
+	short nbuf;
+	uint64_t buf[RETRO_BATCH];
+} RetroWorker;
+
+// ------------------------------------------------------------------------------------ //
+
+// xoshiro256**. Small, fast, and each owner keeps its own: no shared state between threads.
+// Seeded with `rng_seed`. See `Subsection: Random`.
+typedef struct {
+	uint64_t s[4];
+} Rng;
+
+// ------------------------------------------------------------------------------------ //
+
+// One position in the transposition table of a search. 16 bytes.
+typedef struct {
+	uint64_t key;		// Zobrist key of the position. 0: empty.
+	int score;			// See SEARCH_WIN.
+	int16_t depth;		// Plies searched below it, or SEARCH_EXACT.
+	tiny bound;			// SEARCH_BOUND: whether `score` is exact, a floor or a ceiling.
+	tiny move;			// Best pick found, tried first next time.
+} SearchEntry;
+
+typedef enum {
+	SEARCH_BOUND_EXACT,
+	SEARCH_BOUND_LOWER,
+	SEARCH_BOUND_UPPER
+} SEARCH_BOUND;
+
+typedef struct Strategy Strategy;
+
+// What a kind of `Strategy` does. One for each kind, shared by every strategy of it.
+typedef struct {
+	const char* name;
+	// The pick with `remaining` sticks left after the other player picked `last` (0: none),
+	// 0 if every pick loses. Never more than legal.
+	tiny (*pick)(Strategy* strategy, long long remaining, tiny last, Rng* rng);
+	void (*free)(Strategy* strategy);
+} StrategyOps;
+
+// How the computer picks, chosen at runtime: `strategy_table`, `strategy_tablebase`, 
+// `strategy_retro`, `strategy_alphabeta` or `strategy_human`. Holds its own tables, 
+// so give each thread its own.
+// See `Subsection: Strategies`.
+struct Strategy {
+	const StrategyOps* ops;
+	Rules rules;
+	const Solver* solver;		// Of `table`. Not owned.
+	const Tablebase* tablebase;	// Of `tablebase`. Not owned.
+	const Retro* retro;			// Of `retro`. Not owned.
+
+	// Of the searches.
+	uint64_t* zobrist;			// A random key for each pile, 0 to `rules.pool`.
+	SearchEntry* table;			// Transposition table, 2^SEARCH_TT_BITS entries.
+	long long budget_ns;		// Time per pick. 0: none, search `max_depth` plies.
+	int max_depth;				// Plies of the deepest iteration, up to SEARCH_MAX_DEPTH.
+	bool random_ties;			// Picks at random between equally good picks.
+	long long deadline;			// Of the pick being searched. See `monotonic_ns`.
+	bool stopped;				// Out of time: the deepest search is thrown away.
+
+	// Counters, for the benchmark. They only go up.
+	long long nodes, hits;		// Positions searched, and found in the table.
+	int depth;					// Plies of the last completed search.
+};
+
+// ------------------------------------------------------------------------------------ //
+
+// What a replay log stores about one game, besides its picks.
+typedef struct {
+	tiny theme;			// THEME of the player, or REPLAY_NO_THEME.
+	PLAYER first;		// Who picked first. Picks alternate from there.
+	PLAYER winner;
+	bool refused;		// The computer REFUSEd instead of picking the last stick.
+	bool normie;		// The computer picked at random.
+	bool seeded;		// Whether `seed` was stored.
+	uint64_t seed;		// What the session's Rng was seeded with when the game started.
+	long long npicks;
+} ReplayGame;
+
+// Append-only log of finished games, one rule set per file.
+// Picks are packed in as few bits as it takes to number the allowed picks: 2 for 1-4.
+typedef struct {
+	FILE* file;
+	Rules rules;
+	tiny bits;			// Bits per pick.
+	uint8_t* picks;		// Picks of the game being recorded, packed.
+	size_t cap;			// Bytes allocated for `picks`.
+	long long npicks;
+	long ngames;		// Appended since opened.
+	bool failed;		// A write failed. Nothing more is appended.
+} ReplayLog;
+
+// A replay log, memory-mapped for reading. Records are walked in order with `replay_next`.
+typedef struct {
+	const uint8_t* data;
+	size_t size, pos;	// `pos`: Offset of the next record.
+	Rules rules;
+	tiny bits;
+	tiny picks[64];		// The pick each stored number stands for.
+	tiny npicks;		// Allowed picks. Larger stored numbers are corrupt.
+	bool mapped;		// false if the file was read into memory instead.
+} ReplayReader;
+
+// Strategies the headless simulator can put in either seat.
+typedef enum {
+	BOT_OPTIMAL = 0,	// `solver_move`. The same engine IMPOSSIBLE MODE plays with.
+	BOT_RANDOM = 1,		// The normie path. A random legal pick.
+	BOT_SCRIPT = 2		// Replays a fixed list of picks, like "4321".
+} BOT;
+
+typedef struct {
+	BOT bot;
+	const char* script; // Only for BOT_SCRIPT. Digits, cycled over.
+	short nscript;
+} Seat;
+
+typedef struct {
+	long ngames;
+	Rules rules;
+	Seat seats[2];		// Indexed by PLAYER.
+	tiny first;			// PLAYER who starts, or -1 to alternate every game.
+	uint64_t seed;
+	ReplayLog* record;	// If not NULL, every game is appended to it. One thread only.
+} SimConfig;
+
+typedef struct {
+	long games, moves;
+	long wins[2];		// Indexed by PLAYER.
+	long refusals;		// Games the optimal computer REFUSEd to finish. Counted as losses.
+	long picks[2][65];	// How often each PLAYER picked 1 to 64 sticks.
+	long lengths[65];	// Number of games that took n moves. The last slot is 64 or more.
+	double seconds;
+} SimStats;
+
+// ------------------------------------------------------------------------------------ //
+
+// Foreground colors for ANSI terminal.
+typedef enum {
+	FG_DEFAULT = 0,
+	FG_BLACK = 30,
+	FG_RED = 31,
+	FG_GREEN = 32,
+	FG_YELLOW = 33,
+	FG_BLUE = 34,
+	FG_PURPLE = 35,
+	FG_CYAN = 36,
+	FG_WHITE = 37,
+	FG__RGB = 38,
+	FG_BRIGHT_BLACK = 90,
+	FG_BRIGHT_RED = 91,
+	FG_BRIGHT_GREEN = 92,
+	FG_BRIGHT_YELLOW = 93,
+	FG_BRIGHT_BLUE = 94,
+	FG_BRIGHT_PURPLE = 95,
+	FG_BRIGHT_CYAN = 96,
+	FG_BRIGHT_WHITE = 97
+} FG_COLOR;
+
+// Background colors for ANSI terminal.
+typedef enum {
+	BG_DEFAULT = 0,
+	BG_BLACK = 40,
+	BG_RED = 41,
+	BG_GREEN = 42,
+	BG_YELLOW = 43,
+	BG_BLUE = 44,
+	BG_PURPLE = 45,
+	BG_CYAN = 46,
+	BG_WHITE = 47,
+	BG__RGB = 48,
+	BG_BRIGHT_BLACK = 100,
+	BG_BRIGHT_RED = 101,
+	BG_BRIGHT_GREEN = 102,
+	BG_BRIGHT_YELLOW = 103,
+	BG_BRIGHT_BLUE = 104,
+	BG_BRIGHT_PURPLE = 105,
+	BG_BRIGHT_CYAN = 106,
+	BG_BRIGHT_WHITE = 107
+} BG_COLOR;
+
+// Special effect characters for ANSI terminal.
+typedef enum {
+	RESET = 0,
+	BOLD = 1,
+	FAINT = 2,
+	ITALIC = 3,
+	UNDERLINE = 4,
+	BLINK = 5,
+	RAPID_BLINK = 6,
+	REVERSE = 7,
+	HIDE = 8,
+	STRIKE = 9
+} MODIFIER;
+
+
+
+// Opening escape sequence of one style. \033[ + fg; + bg; + 10 modifiers; = 30 bytes.
+typedef struct {
+	uint32_t key;	// SGR_KEY of the style. 0 marks a free slot in `sgr_cache`.
+	tiny len;
+	char seq[31];
+} SgrPrefix;
+
+
+
+// Colored messages of one THEME. Built on first use, then kept until the session ends.
+typedef struct {
+	bool built;
+	const char* messages[nTHEMED]; // Indexed by THEMED(MESSAGE_IDX).
+} Theme;
+
+// ------------------------------------------------------------------------------------ //
+
+// What the board line at the top of the terminal shows, so the next turn only draws
+// what changed. See `draw_board`.
+typedef struct {
+	bool valid;			// false once the screen was cleared or the board never drawn.
+	Board board;		// Game the board line shows.
+	tiny pool;
+	short counter_col;	// 1-based columns of the sticks remaining and the first stick.
+	short sticks_col;
+	FG_COLOR colors[2];	// Of each PLAYER's sticks.
+	size_t full_draws, delta_draws, bytes;
+} Screen;
+
+// Short picks, colored once. Kept apart from the `Screen`, so it stays small for 
+// hosts that keep a `Screen` per player and draw them all with one session.
+typedef struct {
+	FG_COLOR colors[2];	// `segments` of each PLAYER are in these colors.
+	char segments[2][SCREEN_SEGMENTS][SCREEN_SEGMENT_SIZE]; // Colored, "" until needed.
+} Segments;
+
+// ------------------------------------------------------------------------------------ //
+
+// Where the game is, between two steps. See `Subsection: Game Flow`.
+typedef enum {
+	FLOW_START = 0, FLOW_GET_OUT,
+	FLOW_MENU, FLOW_MENU_CHOICE,
+	FLOW_NORMAL, FLOW_NORMAL_LOADED, FLOW_NORMAL_CLEARED, FLOW_NORMAL_SHOWN,
+	FLOW_IMPOSSIBLE, FLOW_IMPOSSIBLE_INTRO, FLOW_IMPOSSIBLE_GUTS, FLOW_IMPOSSIBLE_READY,
+	FLOW_COLOR, FLOW_COLOR_CHOICE, FLOW_ORDER, FLOW_ORDER_CHOICE, FLOW_DEAL,
+	FLOW_TURN, FLOW_HUMAN, FLOW_HUMAN_CHOICE, FLOW_HUMAN_RETRY,
+	FLOW_COMPUTER, FLOW_COMPUTER_PICKED, FLOW_COMPUTER_SEEN,
+	FLOW_OVER, FLOW_OVER_DANCED, FLOW_OVER_RESET, FLOW_OVER_WON, FLOW_OVER_LOSS,
+	FLOW_REFUSE, FLOW_REFUSE_NO, FLOW_REFUSE_CAPS, FLOW_REFUSE_CAPS_DONE, FLOW_REFUSE_MAX,
+	FLOW_NORMIE, FLOW_NORMIE_MAX,
+	FLOW_LOADING, FLOW_DANCE, FLOW_CLEAR,	// Animations. They go on to `Flow.then`.
+	FLOW_END
+} FLOW;
+
+// What a step of the flow leaves the frame for.
+typedef enum {
+	STEP_INPUT = 0,		// The player's next choice. Passed to the next step.
+	STEP_WAIT = 1,		// `Flow.wait_ms` of game time.
+	STEP_END = 2		// Nothing. The session is over.
+} STEP;
+
+// The whole game, from the greeting to the goodbye, as a resumable state machine.
+// Holds no pointers to anything but static strings, so it can be kept, copied and stepped
+// by any session: a few dozen bytes per player. See `Subsection: Game Flow`.
+typedef struct {
+	FLOW state, then;			// `then`: where the animation in `state` goes after.
+	unsigned wait_ms;			// Of the last STEP_WAIT.
+	tiny normieness;			// Times the player asked for normal mode. See `FLOW_NORMAL`.
+	tiny loaded;				// Loading screens of normal mode shown so far.
+	bool started, true_normie;
+	THEME theme;
+	tiny pick;					// The computer's, until it is shown.
+	Board board;				// The game being played.
+
+	// The animation playing: `flow_loading` (dots) or `flow_dance` (text).
+	const char *dots, *text;
+	tiny loops, at;
+	bool newln;
+} Flow;
+
+// ------------------------------------------------------------------------------------ //
+
+// One game, from the first greeting to the goodbye, and everything it needs.
+// Sessions share nothing but the read-only tables, so any number of them may run at once.
+typedef struct {
+	FILE *in, *out;				// Where the player's choices come from, and the game goes.
+	int in_fd, out_fd;			// Their file descriptors, for the reads and writes that skip stdio.
+	const char* noplay_path;	// Marker files that remember the player across runs.
+	const char* normie_path;	// NULL for either means nothing is remembered.
+
+	Frame frame;				// See `Subsection: Frame Buffer`.
+	SgrFilter sgr;				// Applied to every frame. See `Subsection: SGR Filter`.
+	Clock clock;				// See `Subsection: Clock`.
+	Input input;				// See `Subsection: Input`.
+	Screen screen;				// The board on screen. See `draw_board`.
+	Segments segments;			// Sticks drawn so far. See `stick_segment`.
+	Metrics metrics;			// See `Subsection: Metrics`.
+
+	// frame_arena: Temporary strings, reset after each screen is drawn (see `_gc`).
+	// theme_arena: Colored messages of `themes`. Never reset, freed with the session.
+	Arena frame_arena, theme_arena;
+	Theme themes[nTHEMES];
+
+	// Escape prefixes of every style used so far. See `sgr_prefix`.
+	SgrPrefix sgr_cache[SGR_CACHE_SIZE];
+	short nsgr_cache;
+	SgrPrefix sgr_uncached;		// A style that did not fit in the cache, until the next lookup.
+
+	Solver solver;				// The rules of the game, solved. See `solver_init`.
+	Strategy strategy;			// How `computer_pick` picks. `table` unless set up otherwise.
+	Rng rng;					// Every random pick. Reseed before `session_run` to replay a game.
+	ReplayLog* record;			// If not NULL, finished games are appended to it.
+	ReplayGame game;			// The game being played, as it will be recorded.
+} Session;
+
+
+
+// ==================================================================================== //
+//                                   Shared Constants                                   //
+// ==================================================================================== //
+// Read-only. Defined in matchsticks.c.
+
+extern const char* const MESSAGES[nMSG];
+extern const char* const DANCES[nDANCES];
+extern const MODIFIER modheavy[2], modlight[2];
+extern const char *const SMILE, *const TONGUE;
+extern const Rules CLASSIC_RULES;
+
+
+
+// ==================================================================================== //
+//                                 Function Prototypes                                  //
+// ==================================================================================== //
+
+// String Functions
+char* itoa(Session* session, int i);
+char* joinstr(tiny n, ...);
+char* arena_joinstr(Arena* arena, tiny n, ...);
+char* trimquotes(Session* session, const char rawstr[]);
+char* emojify(Session* session, char* rawstr, const char* emoji, char echar);
+const SgrPrefix* sgr_prefix(Session* session, FG_COLOR fg, BG_COLOR bg, 
+	const MODIFIER* mod, tiny nmod);
+size_t strnice_into(Session* session, char* buf, size_t cap, const char* rawstr, 
+	FG_COLOR fg, BG_COLOR bg, const MODIFIER* mod, tiny nmod);
+char* strnice(Session* session, const char* rawstr, FG_COLOR fg, BG_COLOR bg, 
+	const MODIFIER* mod, tiny nmod);
+
+// ------------------------------------------------------------------------------------ //
+
+// MEMORY
+void arena_init(Arena* arena, size_t cap);
+void* arena_alloc(Arena* arena, size_t size);
+void arena_reset(Arena* arena);
+void arena_free(Arena* arena);
+void _gc(Session* session);
+void _gc_full_(Session* session);
+
+// ------------------------------------------------------------------------------------ //
+
+// Declaration
+void buildmessages(Session* session, const char* messages[nMSG], const char* dances[nDANCES]);
+void freemessages(const char* messages[nMSG], const char* dances[nDANCES]);
+void buildtheme(Session* session, THEME theme);
+const char* getmessage(Session* session, THEME theme, MESSAGE_IDX idx);
+
+// ------------------------------------------------------------------------------------ //
+
+// Frame Buffer
+void fb_write(Session* session, const char* str, size_t len);
+void fb_print(Session* session, const char* str);
+void fb_puts(Session* session, const char* str);
+void fb_putc(Session* session, char c);
+void fb_printf(Session* session, const char* fmt, ...);
+const char* fb_take(Session* session, size_t* len);
+void fb_flush(Session* session);
+void pause_frame(Session* session, unsigned ms);
+void tick_frame(Session* session);
+
+// ------------------------------------------------------------------------------------ //
+
+// SGR Filter
+size_t sgr_filter(SgrFilter* filter, const char* in, size_t len);
+void sgr_filter_free(SgrFilter* filter);
+
+// ------------------------------------------------------------------------------------ //
+
+// Clock
+long long monotonic_ns(void);
+void clock_sync(Clock* vclock);
+long long clock_deadline(Clock* vclock, unsigned ms);
+void clock_wait(Clock* vclock, unsigned ms);
+bool clock_wait_fd(Clock* vclock, unsigned ms, int fd);
+bool clock_args(Clock* vclock, int* argc, char* argv[]);
+
+// ------------------------------------------------------------------------------------ //
+
+// Input
+bool input_raw(Session* session);
+void input_restore(Session* session);
+void input_read(Session* session, bool waiting);
+int input_key(Session* session);
+
+// ------------------------------------------------------------------------------------ //
+
+// Metrics
+void metrics_dump(Session* session, FILE* out);
+void metrics_poll(Session* session);
+
+// ------------------------------------------------------------------------------------ //
+
+// Terminal I/O
+tiny getn(Session* session);
+void cls(Session* session);
+void printsticks(Session* session, Board board, tiny pool, 
+	FG_COLOR player_color, FG_COLOR computer_color);
+void draw_board(Session* session, Board board, tiny pool, 
+	FG_COLOR player_color, FG_COLOR computer_color);
+
+// ------------------------------------------------------------------------------------ //
+
+// Random
+void rng_seed(Rng* rng, uint64_t seed);
+uint64_t rng_next(Rng* rng);
+
+// ------------------------------------------------------------------------------------ //
+
+// Board
+Board board_new(PLAYER first);
+Board board_apply(Board board, tiny pick);
+Board board_undo(Board board);
+tiny board_taken(Board board);
+PLAYER board_turn(Board board);
+PLAYER board_owner(Board board, tiny stick);
+tiny board_last(Board board);
+
+// ------------------------------------------------------------------------------------ //
+
+// Replay
+bool replay_open(ReplayLog* log, const char* path, const Rules* rules);
+void replay_push(ReplayLog* log, tiny pick);
+bool replay_end(ReplayLog* log, const ReplayGame* game);
+bool replay_close(ReplayLog* log);
+bool replay_map(ReplayReader* reader, const char* path);
+bool replay_next(ReplayReader* reader, ReplayGame* game, const uint8_t** picks);
+tiny replay_pick(const ReplayReader* reader, const uint8_t* picks, long long n);
+void replay_unmap(ReplayReader* reader);
+void replay_show(Session* session, const ReplayReader* reader, const ReplayGame* game, 
+	const uint8_t* picks);
+
+// ------------------------------------------------------------------------------------ //
+
+// Solver
+uint64_t legal_moves(const Rules* rules, long long remaining);
+tiny random_move(const Rules* rules, long long remaining, uint64_t r);
+bool forced_last(const Rules* rules, long long remaining);
+void solver_init(Solver* solver, Rules rules);
+void solver_init_full(Solver* solver, Rules rules);
+void solver_free(Solver* solver);
+bool solver_losing(const Solver* solver, long long remaining);
+tiny solver_move(const Solver* solver, long long remaining);
+
+// ------------------------------------------------------------------------------------ //
+
+// Tablebase
+long long tablebase_positions(long long max_heap, tiny nheaps);
+bool tablebase_build(Tablebase* tb, Rules rules, tiny nheaps);
+bool tablebase_save(const Tablebase* tb, const char* path);
+bool tablebase_map(Tablebase* tb, const char* path);
+void tablebase_free(Tablebase* tb);
+long long tablebase_index(const Tablebase* tb, const int heaps[]);
+int tablebase_at(const Tablebase* tb, long long rank);
+int tablebase_dtm(const Tablebase* tb, const int heaps[]);
+bool tablebase_win(const Tablebase* tb, const int heaps[]);
+bool tablebase_move(const Tablebase* tb, const int heaps[], tiny* heap, tiny* pick);
+
+// ------------------------------------------------------------------------------------ //
+
+// Grundy
+void grundy_init(Grundy* grundy, Rules rules);
+void grundy_init_scalar(Grundy* grundy, Rules rules);
+void grundy_free(Grundy* grundy);
+bool grundy_win(const Grundy* grundy, const long long piles[], tiny npiles);
+bool grundy_move(const Grundy* grundy, const long long piles[], tiny npiles, tiny* pile, tiny* pick);
+
+// ------------------------------------------------------------------------------------ //
+
+// Retrograde
+short count_cores(void);
+long long retro_states(const Variant* variant);
+uint64_t retro_legal(const Variant* variant, long long remaining, PLAYER player, tiny last);
+bool retro_solve(Retro* retro, Variant variant, short nthreads);
+bool retro_solve_dp(Retro* retro, Variant variant);
+void retro_free(Retro* retro);
+long long retro_index(const Retro* retro, long long remaining, PLAYER player, tiny last);
+bool retro_win(const Retro* retro, long long remaining, PLAYER player, tiny last);
+tiny retro_move(const Retro* retro, long long remaining, PLAYER player, tiny last);
+
+// ------------------------------------------------------------------------------------ //
+
+// Strategies
+void strategy_table(Strategy* strategy, const Solver* solver);
+bool strategy_tablebase(Strategy* strategy, const Tablebase* tablebase, Rules rules);
+void strategy_retro(Strategy* strategy, const Retro* retro);
+bool strategy_alphabeta(Strategy* strategy, Rules rules, long long budget_ns, uint64_t seed);
+bool strategy_human(Strategy* strategy, Rules rules, int depth, uint64_t seed);
+bool strategy_named(Strategy* strategy, const char* name, const Solver* solver, uint64_t seed);
+tiny strategy_pick(Strategy* strategy, long long remaining, tiny last, Rng* rng);
+void strategy_free(Strategy* strategy);
+
+// ------------------------------------------------------------------------------------ //
+
+// Game Functionality
+tiny random_pick(Session* session, tiny choice_sum);
+tiny computer_pick(Session* session, tiny choice_sum, tiny last);
+
+// ------------------------------------------------------------------------------------ //
+
+// Game Flow
+void flow_start(Flow* flow);
+STEP flow_step(Session* session, Flow* flow, tiny choice);
+
+// ------------------------------------------------------------------------------------ //
+
+// Simulation
+bool parse_seat(Seat* seat, const char* arg);
+tiny seat_pick(const Solver* solver, Rng* rng, const Seat* seat, const Rules* rules, 
+	long long remaining, long nmove);
+PLAYER simulate_game(const Solver* solver, Rng* rng, const SimConfig* cfg, PLAYER first, 
+	SimStats* stats);
+bool parse_moves(uint64_t* moves, const char* arg);
+double now_seconds(void);
+void simulate(const Solver* solver, const SimConfig* cfg, SimStats* stats);
+void print_simstats(const SimConfig* cfg, const SimStats* stats);
+
+// ------------------------------------------------------------------------------------ //
+
+// Session
+void session_init(Session* session, FILE* in, FILE* out);
+void session_run(Session* session);
+void session_free(Session* session);
+
+// ------------------------------------------------------------------------------------ //
+// ------------------------------------------------------------------------------------ //
+
+#endif // MATCHSTICKS_H
@@ -0,0 +1,685 @@
+// ==================================================================================== //
+//                                21 Matchsticks: Server                                //
+// ==================================================================================== //
+/*!
+	Hosts any number of players at once, on one thread, over a Unix domain socket.
+
+	Every connection plays its own game, the same game with the same MESSAGES as on a
+	terminal. The game is a state machine (see `Flow`), so a player is only the state
+	that outlives a step: their `Flow`, their random generator, the board on their
+	screen, their terminal's SGR state and their clock. A few hundred bytes.
+	One `Session` draws everyone's frames, a step at a time: the player's state is put
+	in, the flow stepped until it waits, the frame taken out and sent.
+	
+	The loop waits on a single epoll, with the nearest pause as its timeout, and steps
+	whichever player can go on: their line came in, their pause is over, or their socket
+	took the rest of a frame. An idle player costs no CPU.
+
+	Usage:
+		server.bin [--socket PATH] [--max N] [--clock real|fast|instant] [--frame MS]
+		server.bin --bench N [--clock real|fast|instant]		Instant by default.
+
+	Players connect with any line-based client, e.g. `nc -U ./matchsticks.sock`.
+	`--bench` is its own client: it opens N idle players, then times answers to a few.
+	Linux only (epoll).
+!*/
+
+// ==================================================================================== //
+//                                   Translation Unit                                   //
+// ==================================================================================== //
+
+#define _GNU_SOURCE			// accept4
+
+#include "matchsticks.h"
+
+#include <string.h>			// strcmp, strerror, memchr, memcpy
+#include <errno.h>			// errno, EAGAIN, EINTR
+#include <signal.h>			// signal, SIGPIPE, SIGINT, SIGTERM
+#include <unistd.h>			// read, write, close, unlink, getpid, sysconf
+#include <sys/socket.h>		// socket, bind, listen, accept4, connect, recv
+#include <sys/un.h>			// sockaddr_un
+#include <sys/epoll.h>		// epoll_create1, epoll_ctl, epoll_wait
+#include <sys/resource.h>	// getrlimit, setrlimit
+
+// ------------------------------------------------------------------------------------ //
+
+// Preprocessor-level Constants
+#define SERVER_EVENTS 256				// Taken from epoll per wakeup.
+#define SERVER_SOCKET "./matchsticks.sock"
+#define SERVER_PEEK 64					// Looked at per `recv` for the end of a line.
+#define LINE_NONE -2					// See `conn_line`.
+
+// ==================================================================================== //
+//                                        Types                                         //
+// ==================================================================================== //
+
+struct Server;
+
+// One player. Everything of their game that outlives a step. See `conn_step`.
+typedef struct {
+	Flow flow;
+	Rng rng;
+	ReplayGame game;
+	Screen screen;
+	SgrState term, want;	// Of their terminal, for the SGR filter.
+	Clock clock;			// Their pauses.
+
+	struct Server* server;
+	int fd;
+	int line;				// First character of the line coming in. -1 before it does.
+	STEP step;				// What the last frame waits for. 
+	bool ready;				// It is over: step the flow next.
+	bool paused, reading;	// In `Server.timers`, or waiting on the player.
+	long long deadline;		// Of the pause. Its key in `Server.timers`.
+	char* backlog;			// End of the last frame, not taken by the socket yet.
+	size_t nbacklog;
+} Conn;
+
+typedef struct Server {
+	int listen_fd, epoll_fd;
+	const char* path;
+	Clock vclock;			// Every player starts with a copy.
+	Session render;			// Draws every player's frames.
+
+	Conn** timers;			// Min-heap on `deadline` of the players in a pause.
+	long ntimers, timers_cap;
+
+	long nconns, max_conns, nreading;	// `nreading`: waiting on the player. Idle.
+	size_t accepted, finished, steps, wakeups;
+} Server;
+
+
+
+// ==================================================================================== //
+//                                 Function Prototypes                                  //
+// ==================================================================================== //
+
+// Timers
+void timer_push(Server* server, Conn* conn);
+Conn* timer_pop(Server* server);
+
+// ------------------------------------------------------------------------------------ //
+
+// Connections
+void conn_step(Conn* conn, tiny choice);
+int conn_line(Conn* conn);
+void conn_run(Conn* conn);
+bool conn_open(Server* server, int fd);
+void conn_close(Conn* conn);
+
+// ------------------------------------------------------------------------------------ //
+
+// Server
+bool server_open(Server* server, const char* path, long max_conns);
+void server_poll(Server* server, int timeout_ms);
+void server_close(Server* server);
+void raise_fd_limit(void);
+long resident_kb(void);
+int bench_main(Server* server, long nclients);
+
+
+
+// ==================================================================================== //
+//                                   Implementations                                    //
+// ==================================================================================== //
+
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Timers                                  //
+// ------------------------------------------------------------------------------------ //
+/*
+	A player waits for one thing at a time, so a player in a pause is in the heap
+	exactly once, and leaves it only when its deadline comes. No decrease-key needed.
+*/
+
+void timer_push(Server* server, Conn* conn) {
+	/*
+		@param Server* server:	The server.
+		@param Conn* conn:		Player starting a pause until `conn->deadline`.
+	*/
+	if (server->ntimers == server->timers_cap) {
+		long cap = server->timers_cap ? server->timers_cap * 2 : 64;
+		Conn** timers = realloc(server->timers, cap * sizeof(Conn*));
+		if (!timers) {
+			fprintf(stderr, "Out of memory.\n");
+			exit(1);
+		}
+		server->timers = timers;
+		server->timers_cap = cap;
+	}
+
+	long at = server->ntimers++;
+	while (at && server->timers[(at - 1) / 2]->deadline > conn->deadline) {
+		server->timers[at] = server->timers[(at - 1) / 2];
+		at = (at - 1) / 2;
+	}
+	server->timers[at] = conn;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+Conn* timer_pop(Server* server) {
+	/*
+		@param Server* server:	The server. At least one player in a pause.
+		@return Conn*:			The player whose pause ends first.
+	*/
+	Conn** heap = server->timers;
+	Conn *top = heap[0], *last = heap[--server->ntimers];
+	long at = 0, n = server->ntimers;
+	INF_LOOP {
+		long child = 2 * at + 1;
+		if (child >= n) break;
+		if (child + 1 < n && heap[child + 1]->deadline < heap[child]->deadline) child++;
+		if (heap[child]->deadline >= last->deadline) break;
+		heap[at] = heap[child];
+		at = child;
+	}
+	heap[at] = last;
+	return top;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                               Subsection: Connections                                //
+// ------------------------------------------------------------------------------------ //
+
+static void conn_send(Conn* conn, const char* data, size_t len) {
+	/*
+		Writes as much as the socket takes, and keeps the rest in the backlog.
+		If the player is gone, nothing is kept and the game ends.
+
+		@param Conn* conn:			The player. Nothing in the backlog but `data` itself.
+		@param const char* data:	Frame bytes.
+		@param size_t len:			How many.
+	*/
+	size_t done = 0;
+	while (done < len) {
+		long n = write(conn->fd, data + done, len - done);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0 && errno == EAGAIN) break;
+		if (n <= 0) { // Hung up. Nothing left to show it on.
+			free(conn->backlog);
+			conn->backlog = NULL;
+			conn->nbacklog = 0;
+			conn->step = STEP_END;
+			conn->ready = false;
+			return;
+		}
+		done += n;
+	}
+
+	if (data == conn->backlog) { // Draining. Keep what is left at the front.
+		memmove(conn->backlog, data + done, len - done);
+		conn->nbacklog = len - done;
+		if (!conn->nbacklog) free(conn->backlog), conn->backlog = NULL;
+		return;
+	}
+	if (done == len) return;
+	conn->backlog = malloc(len - done);
+	if (!conn->backlog) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+	memcpy(conn->backlog, data + done, len - done);
+	conn->nbacklog = len - done;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void conn_step(Conn* conn, tiny choice) {
+	/*
+		Steps the player's flow on the shared session, and sends the frame it drew.
+		The player's state goes into the session first and comes back out after.
+		The frame arena is emptied: a flow keeps nothing in it between steps.
+
+		@param Conn* conn:		The player. Nothing in the backlog.
+		@param tiny choice:		Their answer, if the flow waits for one. See `flow_step`.
+	*/
+	Server* server = conn->server;
+	Session* render = &server->render;
+	render->rng = conn->rng;
+	render->game = conn->game;
+	render->screen = conn->screen;
+	render->sgr.term = conn->term;
+	render->sgr.want = conn->want;
+
+	conn->step = flow_step(render, &conn->flow, choice);
+	conn->ready = false;
+	server->steps++;
+
+	size_t len;
+	const char* frame = fb_take(render, &len);
+	arena_reset(&render->frame_arena);
+	conn->rng = render->rng;
+	conn->game = render->game;
+	conn->screen = render->screen;
+	conn->term = render->sgr.term;
+	conn->want = render->sgr.want;
+	if (len) conn_send(conn, frame, len);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+int conn_line(Conn* conn) {
+	/*
+		Reads the player's next line, and gives its first character, as `getn` would.
+		The rest of the line is dropped. Lines after it stay in the socket, for the
+		prompts after.
+
+		@param Conn* conn:	The player.
+		@return int:		The character, '\n' for an empty line, EOF once the player left,
+							LINE_NONE while the line is not complete.
+	*/
+	char buf[SERVER_PEEK];
+	INF_LOOP {
+		long n = recv(conn->fd, buf, sizeof(buf), MSG_PEEK);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0 && errno == EAGAIN) return LINE_NONE;
+		if (n <= 0) return EOF;
+
+		char* end = memchr(buf, '\n', n);
+		long take = end ? end - buf + 1 : n;
+		if (conn->line < 0) conn->line = (unsigned char) buf[0];
+		if (recv(conn->fd, buf, take, 0) != take) return EOF; // Peeked bytes are there.
+		if (end) {
+			int first = conn->line;
+			conn->line = -1;
+			return first;
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void conn_run(Conn* conn) {
+	/*
+		Carries the player's game on as far as it goes without waiting: sends what is left
+		of the last frame, takes their choice or starts the pause, steps the flow, and
+		again. Returns once it waits on the socket or the clock. Closes the connection 
+		when the game ends or the player leaves.
+
+		@param Conn* conn:	The player.
+	*/
+	Server* server = conn->server;
+	tiny choice = -1;
+	INF_LOOP {
+		if (conn->nbacklog) conn_send(conn, conn->backlog, conn->nbacklog);
+		if (conn->nbacklog) return; // Socket full. EPOLLOUT brings it back.
+
+		if (!conn->ready) {
+			if (conn->step == STEP_END) break;
+			if (conn->step == STEP_WAIT) {
+				if (conn->paused) return;
+				conn->deadline = clock_deadline(&conn->clock, conn->flow.wait_ms);
+				if (conn->deadline) { // 0: the clock is instant. Nothing to wait for.
+					conn->paused = true;
+					timer_push(server, conn);
+					return;
+				}
+			}
+			if (conn->step == STEP_INPUT) {
+				int c = conn_line(conn);
+				if (c == LINE_NONE) {
+					if (!conn->reading) conn->reading = true, server->nreading++;
+					return;
+				}
+				if (conn->reading) conn->reading = false, server->nreading--;
+				if (c == EOF) break; // The player left.
+				choice = c == '\n' ? -1 : c - '0';
+				clock_sync(&conn->clock); // Animations start over from now, as after `getn`.
+			}
+		}
+		conn_step(conn, choice);
+		choice = -1;
+	}
+	conn_close(conn);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool conn_open(Server* server, int fd) {
+	/*
+		Starts a game on a new connection, and runs it up to its first prompt.
+
+		@param Server* server:	The server.
+		@param int fd:			Accepted socket, non-blocking. Closed on failure.
+		@return bool:			false if out of memory, or epoll cannot watch the socket
+								(ENOMEM, or the max_user_watches limit).
+	*/
+	Conn* conn = malloc(sizeof(Conn));
+	if (!conn) {
+		close(fd);
+		return false;
+	}
+	*conn = (Conn) {
+		.server = server, .fd = fd, .line = -1, .clock = server->vclock, .ready = true
+	};
+	flow_start(&conn->flow);
+	rng_seed(&conn->rng, monotonic_ns() ^ (uintptr_t) conn);
+
+	// Edge-triggered: a player reads and writes until EAGAIN before it waits.
+	struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, .data.ptr = conn};
+	if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev)) {
+		// Never woken again, it would hold a place until `--max` turns everyone away.
+		fprintf(stderr, "epoll_ctl: %s\n", strerror(errno));
+		close(fd);
+		free(conn);
+		return false;
+	}
+
+	server->nconns++;
+	server->accepted++;
+	conn_run(conn);
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void conn_close(Conn* conn) {
+	/*
+		Hangs up on a player whose game ended. Closing the socket takes it out of epoll.
+
+		@param Conn* conn:	The player. Not in a pause. Freed.
+	*/
+	Server* server = conn->server;
+	if (conn->reading) server->nreading--;
+
+	// Lines never read are dropped first. Closed with them still queued, the socket would
+	// be reset, and the player could lose the end of the last frame.
+	char unread[SERVER_PEEK];
+	while (recv(conn->fd, unread, sizeof(unread), 0) > 0);
+	close(conn->fd);
+	free(conn->backlog);
+	free(conn);
+	server->nconns--;
+	server->finished++;
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Server                                  //
+// ------------------------------------------------------------------------------------ //
+
+bool server_open(Server* server, const char* path, long max_conns) {
+	/*
+		Listens on `path`, replacing any socket left there.
+
+		@param Server* server:	Server to set up. Its clock is set by the caller.
+		@param const char* path:	Where the socket goes.
+		@param long max_conns:	Players at once. Connections past that are hung up on.
+		@return bool:			false if the socket cannot be set up. Printed to stderr.
+	*/
+	struct sockaddr_un addr = {.sun_family = AF_UNIX};
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket path too long: %s\n", path);
+		return false;
+	}
+	strcpy(addr.sun_path, path);
+	unlink(path);
+
+	server->path = path;
+	server->max_conns = max_conns;
+	session_init(&server->render, NULL, NULL); // Draws only. Every write is `conn_send`.
+	server->render.clock = server->vclock;
+	server->render.noplay_path = server->render.normie_path = NULL; // Players do not share markers.
+	server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL}; // NULL: the listener.
+
+	if (server->listen_fd < 0 || server->epoll_fd < 0
+		|| bind(server->listen_fd, (struct sockaddr*) &addr, sizeof(addr))
+		|| listen(server->listen_fd, SOMAXCONN)
+		|| epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &ev)) {
+		fprintf(stderr, "Cannot listen on %s: %s\n", path, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static void server_accept(Server* server) {
+	/*
+		Takes every waiting connection. Each game runs up to its first prompt right away.
+	*/
+	INF_LOOP {
+		int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			if (errno != EAGAIN) fprintf(stderr, "accept: %s\n", strerror(errno));
+			return; // EMFILE too: the rest wait in the backlog until someone leaves.
+		}
+		if (server->nconns >= server->max_conns) close(fd); // Full. Try again later.
+		else conn_open(server, fd);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void server_poll(Server* server, int timeout_ms) {
+	/*
+		One turn of the event loop: waits for sockets or the nearest pause, then carries on
+		every game that can go on.
+
+		@param Server* server:	The server.
+		@param int timeout_ms:	Longest wait with nothing to do. -1 for no limit.
+	*/
+	if (server->ntimers) {
+		long long left = server->timers[0]->deadline - monotonic_ns();
+		int ms = left > 0 ? (left + 999999) / 1000000 : 0;
+		if (timeout_ms < 0 || ms < timeout_ms) timeout_ms = ms;
+	}
+
+	struct epoll_event events[SERVER_EVENTS];
+	int n = epoll_wait(server->epoll_fd, events, SERVER_EVENTS, timeout_ms);
+	server->wakeups++;
+
+	for (int i = 0; i < n; i++) {
+		Conn* conn = events[i].data.ptr;
+		uint32_t got = events[i].events;
+		if (!conn) {
+			server_accept(server);
+			continue;
+		}
+		// In a pause, it reads and writes when it is over. Otherwise, if it waits on this.
+		bool gone = got & (EPOLLHUP | EPOLLERR);
+		if ((conn->reading && (got & (EPOLLIN | EPOLLRDHUP) || gone))
+			|| (conn->nbacklog && (got & EPOLLOUT || gone))) conn_run(conn);
+	}
+
+	long long now = monotonic_ns();
+	while (server->ntimers && server->timers[0]->deadline <= now) {
+		Conn* conn = timer_pop(server);
+		conn->paused = false;
+		conn->ready = true;
+		conn_run(conn);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void server_close(Server* server) {
+	/*
+		Stops listening. Games still open are left as they are; the process is ending.
+
+		@param Server* server:	The server.
+	*/
+	close(server->listen_fd);
+	close(server->epoll_fd);
+	unlink(server->path);
+	free(server->timers);
+	session_free(&server->render);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void raise_fd_limit(void) {
+	/*
+		Every player is a socket. The soft limit on files (often 1024) goes up to
+		the hard one.
+	*/
+	struct rlimit lim;
+	if (getrlimit(RLIMIT_NOFILE, &lim)) return;
+	lim.rlim_cur = lim.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &lim);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+long resident_kb(void) {
+	/*
+		@return long:	Memory the process actually uses, in KB. 0 if unknown.
+	*/
+	FILE* statm = fopen("/proc/self/statm", "r");
+	long size, resident = 0;
+	if (statm) {
+		if (fscanf(statm, "%ld %ld", &size, &resident) != 2) resident = 0;
+		fclose(statm);
+	}
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+static bool drain(int fd) {
+	/*
+		Reads whatever a client stand-in was sent.
+
+		@return bool:	Whether there was anything.
+	*/
+	char buf[4096];
+	bool any = false;
+	while (read(fd, buf, sizeof(buf)) > 0) any = true;
+	return any;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+int bench_main(Server* server, long nclients) {
+	/*
+		Client stand-in. Connects `nclients` players that do nothing, and reports what
+		it took to bring them all to the first prompt and what they cost in memory.
+		Then some of them choose normal mode (1), one at a time, and the time until the
+		answer shows is taken with every other player still connected. Then all hang up.
+
+		@param Server* server:	Listening server, run from here.
+		@param long nclients:	Idle players to connect.
+		@return int:			Exit code.
+	*/
+	int* clients = malloc(nclients * sizeof(int));
+	struct sockaddr_un addr = {.sun_family = AF_UNIX};
+	strcpy(addr.sun_path, server->path);
+	if (!clients) return fprintf(stderr, "Out of memory.\n"), 1;
+
+	long base_kb = resident_kb();
+	double start = now_seconds();
+	for (long c = 0; c < nclients; c++) {
+		clients[c] = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (clients[c] < 0) {
+			fprintf(stderr, "Cannot open client %ld: %s. Try fewer.\n", c, strerror(errno));
+			return 1;
+		}
+		// The backlog is full: let the server take some in.
+		while (connect(clients[c], (struct sockaddr*) &addr, sizeof(addr)) && errno == EAGAIN)
+			server_poll(server, 0);
+	}
+	while (server->nreading < nclients) server_poll(server, 10);
+	double secs = now_seconds() - start;
+	long kb = resident_kb() - base_kb;
+	for (long c = 0; c < nclients; c++) drain(clients[c]);
+
+	printf("%-28s %12ld\n", "idle players", server->nconns);
+	printf("%-28s %12.3f\n", "seconds to first prompt", secs);
+	printf("%-28s %12.0f\n", "players/sec", nclients / secs);
+	printf("%-28s %12.1f\n", "KB per player", (double) kb / nclients);
+	printf("%-28s %12zu\n", "bytes per player (Conn)", sizeof(Conn));
+	printf("%-28s %12zu\n", "bytes of the shared Session", sizeof(Session));
+
+	// Nothing happens while they are all idle.
+	size_t wakeups = server->wakeups;
+	server_poll(server, 200);
+	printf("%-28s %12zu\n", "wakeups idle for 200ms", server->wakeups - wakeups);
+
+	// Answers, with everyone else still connected. Normal mode shows a loading screen.
+	long nanswers = nclients < 1000 ? nclients : 1000;
+	double total = 0, worst = 0;
+	for (long c = 0; c < nanswers; c++) {
+		long at = c * (nclients / nanswers);
+		double sent = now_seconds();
+		if (write(clients[at], "1\n", 2) != 2) break;
+		do server_poll(server, 10); while (!drain(clients[at]));
+		double took = now_seconds() - sent;
+		total += took;
+		if (took > worst) worst = took;
+	}
+	printf("%-28s %12.1f\n", "us to answer, average", total / nanswers * 1e6);
+	printf("%-28s %12.1f\n", "us to answer, worst", worst * 1e6);
+
+	start = now_seconds();
+	for (long c = 0; c < nclients; c++) close(clients[c]);
+	while (server->nconns) server_poll(server, 10);
+	printf("%-28s %12.3f\n", "seconds until all have left", now_seconds() - start);
+	printf("%-28s %12zu\n", "flow steps", server->steps);
+	free(clients);
+	return 0;
+}
+
+
+
+// |==================================================================================| //
+// |==================================================================================| //
+// |                                       MAIN                                       | //
+// |==================================================================================| //
+// |==================================================================================| //
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig) {
+	(void) sig;
+	stop = 1;
+}
+
+int main(int argc, char* argv[]) {
+	static Server server;
+	const char* path = SERVER_SOCKET;
+	char bench_path[64];
+	long max_conns = 1000000, nbench = 0;
+
+	// The bench does not wait out the pauses it causes, unless told to.
+	server.vclock = (Clock) {.mode = CLK_REAL, .frame_ms = FRAME_MS};
+	for (int a = 1; a < argc; a++) if (!strcmp(argv[a], "--bench")) server.vclock.mode = CLK_INSTANT;
+	bool ok = clock_args(&server.vclock, &argc, argv);
+	for (int a = 1; ok && a < argc; a += 2) {
+		const char* val = a + 1 < argc ? argv[a + 1] : NULL;
+		if (!strcmp(argv[a], "--socket") && val) path = val;
+		else if (!strcmp(argv[a], "--max") && val) max_conns = atol(val), ok = max_conns > 0;
+		else if (!strcmp(argv[a], "--bench") && val) nbench = atol(val), ok = nbench > 0;
+		else ok = false;
+	}
+	if (!ok) {
+		fprintf(stderr, "Usage: %s [--socket PATH] [--max N] [--clock real|fast|instant] [--frame MS]\n"
+			"       %s --bench N [--clock real|fast|instant]\n", argv[0], argv[0]);
+		return 2;
+	}
+
+	signal(SIGPIPE, SIG_IGN); // A player hanging up is a failed write, not the end of us.
+	raise_fd_limit();
+	if (nbench) {
+		snprintf(bench_path, sizeof(bench_path), "/tmp/matchsticks-%d.sock", (int) getpid());
+		path = bench_path;
+	}
+	if (!server_open(&server, path, max_conns)) return 1;
+
+	int status = 0;
+	if (nbench) status = bench_main(&server, nbench);
+	else {
+		signal(SIGINT, on_signal);
+		signal(SIGTERM, on_signal);
+		fprintf(stderr, "Listening on %s\n", path);
+		while (!stop) server_poll(&server, -1);
+		fprintf(stderr, "\n%zu PLAYERS, %zu LEFT, %ld STILL PLAYING\n", server.accepted,
+			server.finished, server.nconns);
+	}
+	server_close(&server);
+	return status;
+}
@@ -185,188 +185,20 @@ Stress Test Checklist:
 // ------------------------------------------------------------------------------------ //
 
 
-
 // ==================================================================================== //
 //                                   Translation Unit                                   //
 // ==================================================================================== //
+/*
+	The game itself is libmatchsticks (matchsticks.h, matchsticks.c). 
+	This file is the program around it: the command line, the headless mode 
+	and the benchmarks.
+*/
 
-#include <stdio.h>		// printf, getchar, putchar, puts, fprintf, fopen, fclose, 
-						// stdin, stdout, stderr
-											 
-#include <stdlib.h>		// malloc, free, exit
-#include <stdarg.h>		// va_list, va_arg, va_start, va_end
-#include <stdbool.h>	// bool, true, false.
+#include "matchsticks.h"
 
-#include <string.h>		// strlen
-#include <math.h>		// log10, srand, rand
+#include <string.h>		// strcmp
 #include <time.h>		// time
-
-// sleep() is an os function. So we need to handle it with care.
-#ifdef _WIN32
-	#include <windows.h> // Sleep
-	#define sleep(x) Sleep(x*1000)
-	#define itoa(x) itoa_(x) // Apparently x86_64-w64-migw32-gcc's stdlib CONTAINS itoa...
-#else
-	#include <unistd.h> // sleep
-#endif
-
-// ------------------------------------------------------------------------------------ //
-
-// Macros
-#define R(str) #str // Get the stringized value. Basically, load the rawstring.
-#define INF_LOOP while(1)
-
-// Preprocessor-level Constants
-#define nMSG 32
-#define nDANCES 8
-
-// Debug Directive (Disabled)
-// Use gcc -D DEBUG
-// #define DEBUG
-
-// ==================================================================================== //
-//                                        Types                                         //
-// ==================================================================================== //
-
-// `char` is also a numeric type and for our purposes, it will save memory.
-typedef char tiny; 
-
-typedef enum {
-	HUMAN = 0,
-	COMPUTER = 1
-} PLAYER;
-
-// These make it easy to find the correct messages, instead of remembering magic values.
-// Also makes alterations handled well.
-typedef enum {
-	// 7
-	emj_smile,
-	emj_happy,
-	emj_angry,
-	emj_evil,
-	emj_taunt,
-	emj_sad,
-	emj_cry,
-
-	// 5
-	greeting,
-	alt_greeting,
-	mode_choice,
-	nerfed_mode_choice,
-	color_choice_msg,
-
-	// 4
-	goodbye,
-	normie,
-	guts,
-	true_normie,
-
-	// 5
-	invalid_choice,
-	invalid_choice_guts,
-	good_choice,
-	bad_choice,
-	get_out,
-
-	// 6
-	plr_pref_choice,
-	plr_choice_4,
-	plr_choice_3,
-	plr_choice_2,
-	plr_choice_1,
-	cmp_choice,
-
-	// 5
-	dance_msg,
-	replay,
-	true_normie_win,
-	true_normie_loss,
-	normie_max
-		
-} MESSAGE_IDX ;
-
-// ------------------------------------------------------------------------------------ //
-
-// Foreground colors for ANSI terminal.
-typedef enum {
-	FG_DEFAULT = 0,
-	FG_BLACK = 30,
-	FG_RED = 31,
-	FG_GREEN = 32,
-	FG_YELLOW = 33,
-	FG_BLUE = 34,
-	FG_PURPLE = 35,
-	FG_CYAN = 36,
-	FG_WHITE = 37,
-	FG__RGB = 38,
-	FG_BRIGHT_BLACK = 90,
-	FG_BRIGHT_RED = 91,
-	FG_BRIGHT_GREEN = 92,
-	FG_BRIGHT_YELLOW = 93,
-	FG_BRIGHT_BLUE = 94,
-	FG_BRIGHT_PURPLE = 95,
-	FG_BRIGHT_CYAN = 96,
-	FG_BRIGHT_WHITE = 97
-} FG_COLOR;
-
-// Background colors for ANSI terminal.
-typedef enum {
-	BG_DEFAULT = 0,
-	BG_BLACK = 40,
-	BG_RED = 41,
-	BG_GREEN = 42,
-	BG_YELLOW = 43,
-	BG_BLUE = 44,
-	BG_PURPLE = 45,
-	BG_CYAN = 46,
-	BG_WHITE = 47,
-	BG__RGB = 48,
-	BG_BRIGHT_BLACK = 100,
-	BG_BRIGHT_RED = 101,
-	BG_BRIGHT_GREEN = 102,
-	BG_BRIGHT_YELLOW = 103,
-	BG_BRIGHT_BLUE = 104,
-	BG_BRIGHT_PURPLE = 105,
-	BG_BRIGHT_CYAN = 106,
-	BG_BRIGHT_WHITE = 107
-} BG_COLOR;
-
-// Special effect characters for ANSI terminal.
-typedef enum {
-	RESET = 0,
-	BOLD = 1,
-	FAINT = 2,
-	ITALIC = 3,
-	UNDERLINE = 4,
-	BLINK = 5,
-	RAPID_BLINK = 6,
-	REVERSE = 7,
-	HIDE = 8,
-	STRIKE = 9
-} MODIFIER;
-
-
-
-// ==================================================================================== //
-//                                      Constants                                       //
-// ==================================================================================== //
-
-MODIFIER *modheavy, *modlight;
-const char *MESSAGES[nMSG], *DANCES[nDANCES];
-const char *SMILE = "\U0001F600", *TONGUE = "\U0001F61B"; // Unicode Emojis.
-short ncache = 0;
-tiny normieness = 0;
-void *cache[512];
-
-// I've obfuscated these >:). 
-// TOOL: ChatGPT
-const long TARGETS[5] = {
-	(0xAB12CDL ^ 0xAB12CDL ^ (0x123450L & 0x000000L) ^ 0x0F1E2DL ^ 0x0F1E2DL ^ (0x000001L | 0x000000L)),
-	(0x1A2B3CL ^ 0x1A2B3CL ^ (0x123456L & 0x000000L) ^ 0xABCDEFL ^ 0xABCDEFL ^ (0x000005L | 0x000000L)),
-	(0xC001D0L ^ 0xC001D0L ^ (0x654321L & 0x000000L) ^ 0xF0E1D2L ^ 0xF0E1D2L ^ (0x00000AL | 0x000000L)),
-	(0x0FABCDL ^ 0x0FABCDL ^ (0xDEAD10L & 0x000000L) ^ 0x111222L ^ 0x111222L ^ (0x00000FL | 0x000000L)),
-	(0xA1B2C3L ^ 0xA1B2C3L ^ (0xB2C3D4L & 0x000000L) ^ 0xC3D4E5L ^ 0xC3D4E5L ^ (0x000014L | 0x000000L))
-};
+#include <signal.h>		// sigaction, SIGUSR1. See `Subsection: Metrics`.
 
 
 
@@ -374,1064 +206,1058 @@ const long TARGETS[5] = {
 //                                 Function Prototypes                                  //
 // ==================================================================================== //
 
-// String Functions
-char* itoa(int i);
-char* joinstr(tiny n, ...);
-char* trimquotes(const char rawstr[]);
-char* emojify(char* rawstr, const char* emoji, char echar);
-char* strnice(const char* rawstr, FG_COLOR fg, BG_COLOR bg, MODIFIER* mod, tiny nmod);
+// Headless
+int simulation_main(int argc, char* argv[]);
 
 // ------------------------------------------------------------------------------------ //
 
-// MEMORY
-void _gc(void);
-void _gc_full_(void);
+// Replays
+int replay_main(int argc, char* argv[], Clock vclock);
 
 // ------------------------------------------------------------------------------------ //
 
-// Declaration
-void setmessages(void);
-void setmessages_customcolor(FG_COLOR player_color, FG_COLOR computer_color);
+// Tablebases
+int tablebase_main(int argc, char* argv[]);
 
 // ------------------------------------------------------------------------------------ //
 
-// Terminal I/O
-tiny getn(void);
-void cls(void);
-void loading(tiny nloops, const char* loading_txt, const char* dots, bool newln);
-void printsticks(tiny choices[21], tiny choice_sum, FG_COLOR player_color, FG_COLOR computer_color);
-void dance(const char *message, tiny nloop);
+// Retrograde
+int retrograde_main(int argc, char* argv[]);
+static void print_picks(const char* who, uint64_t moves);
 
 // ------------------------------------------------------------------------------------ //
 
-// Game Functionality
-tiny computer_choose(tiny choice_sum, bool random); 
-void REFUSE(void);
-void NORMIE(void);
-void wrong_input(bool guts);
-void normal_mode(void);
-void impossible_mode(bool is_true_normie);
-
-// ------------------------------------------------------------------------------------ //
-// ------------------------------------------------------------------------------------ //
+// Benchmarks
+void bench_solver(Rules rules, uint64_t seed);
+void bench_startup(void);
+void bench_render(uint64_t seed);
+void bench_sgr(uint64_t seed);
+void bench_helpers(uint64_t seed);
+void bench_grundy(Rules rules);
+void bench_strategies(Rules rules, uint64_t seed);
+static int compare_ns(const void* a, const void* b);
 
 
 
 // ==================================================================================== //
-//                          Function Implementations - Helpers                          //
+//                                   Implementations                                    //
 // ==================================================================================== //
 
 // ------------------------------------------------------------------------------------ //
-//                           Subsection: String Functionality                           //
+//                                 Subsection: Headless                                 //
 // ------------------------------------------------------------------------------------ //
 
-char* itoa(int i) {
-	/* 
-		Converts an integer (i) to a string (a).
+int simulation_main(int argc, char* argv[]) {
+	/*
+		Entry point of the headless mode. Parses the arguments and runs the simulation.
 
-		@param int i:	The integer to convert to string.
-		@return char*:	The required string.
+		@param int argc:		Argument count, as passed to main.
+		@param char* argv[]:	Arguments, as passed to main.
+		@return int:			Exit code.
 	*/
-	
-	tiny digs = log10(i) + 1;
-	char* a = malloc(digs + 1);
-	for (tiny n = digs - 1; n >= 0; n--) {
-		*(a + n) = (i % 10) + '0';
-		i /= 10;
-	}
-	*(a + digs) = 0;
-	cache[ncache++] = a;
-	return a;
-}
+	const char *bench = NULL, *record = NULL;
+	SimConfig cfg = {
+		.ngames = 0,
+		.rules = CLASSIC_RULES,
+		.seats = {{.bot = BOT_RANDOM}, {.bot = BOT_OPTIMAL}},
+		.first = -1,
+		.seed = time(0)
+	};
 
-// ------------------------------------------------------------------------------------ //
+	for (int a = 1; a < argc; a++) {
+		const char* arg = argv[a];
+		const char* val = a + 1 < argc ? argv[a + 1] : NULL;
+		bool ok = val != NULL;
+
+		if (!strcmp(arg, "--simulate") && ok) cfg.ngames = atol(val), ok = cfg.ngames > 0;
+		else if (!strcmp(arg, "--human") && ok) ok = parse_seat(&cfg.seats[HUMAN], val);
+		else if (!strcmp(arg, "--computer") && ok) ok = parse_seat(&cfg.seats[COMPUTER], val);
+		else if (!strcmp(arg, "--seed") && ok) cfg.seed = strtoull(val, NULL, 10);
+		else if (!strcmp(arg, "--record") && ok) record = val;
+		else if (!strcmp(arg, "--bench") && ok) 
+			bench = val, ok = !strcmp(val, "solver") || !strcmp(val, "startup") || !strcmp(val, "render")
+				|| !strcmp(val, "sgr") || !strcmp(val, "helpers") || !strcmp(val, "grundy")
+				|| !strcmp(val, "strategies");
+		else if (!strcmp(arg, "--pool") && ok) cfg.rules.pool = atoll(val), ok = cfg.rules.pool > 0;
+		else if (!strcmp(arg, "--moves") && ok) ok = parse_moves(&cfg.rules.moves, val);
+		else if (!strcmp(arg, "--normal")) {
+			cfg.rules.misere = false;
+			continue; // Takes no value.
+		}
+		else if (!strcmp(arg, "--first") && ok) {
+			if (!strcmp(val, "human")) cfg.first = HUMAN;
+			else if (!strcmp(val, "computer")) cfg.first = COMPUTER;
+			else if (!strcmp(val, "alternate")) cfg.first = -1;
+			else ok = false;
+		}
+		else ok = false;
+
+		if (!ok) {
+			fprintf(stderr, "Invalid argument: %s\n", arg);
+			fprintf(stderr, "Usage: %s --simulate N [--human BOT] [--computer BOT] "
+				"[--first human|computer|alternate] [--seed S] [--pool N] [--moves 1,3,4] [--normal]\n"
+				"                   [--record FILE]\n"
+				"       %s --bench solver|startup|render|sgr|helpers|grundy|strategies\n"
+				"                   [--pool N] [--moves 1,3,4] [--normal] [--seed S]\n"
+				"\tBOT is optimal, random or a script of picks such as 4321.\n", argv[0], argv[0]);
+			return 2;
+		}
+		a++; // Skip the value.
+	}
 
-char* joinstr(tiny n, ...) {
-	/*
-		Gets the concatenated string. 
-		Substitute of `strcat`.
-		
-		Note that the use of pointer notation 
-			*(ptr + i) = val;
-		is intentional for demonstrating its capabilities. 
-		It is not a good practice and the sugar
-			ptr[i] = val;
-		is preferred.
-
-		@param tiny n: 	Number of strings to concatenate.
-		@vararg: 		Said strings to concatenate.
-		@return char*: 	Concatenated string.
-	*/
+	if (bench) {
+		if (!strcmp(bench, "solver")) bench_solver(cfg.rules, cfg.seed);
+		if (!strcmp(bench, "startup")) bench_startup();
+		if (!strcmp(bench, "render")) bench_render(cfg.seed);
+		if (!strcmp(bench, "sgr")) bench_sgr(cfg.seed);
+		if (!strcmp(bench, "helpers")) bench_helpers(cfg.seed);
+		if (!strcmp(bench, "grundy")) bench_grundy(cfg.rules);
+		if (!strcmp(bench, "strategies")) bench_strategies(cfg.rules, cfg.seed);
+		return 0;
+	}
 
-	va_list args;
-	va_start(args, n); // Initialize varargs to va_list. It stores all varargs.
-	
-	int len = 0, idx = 0;
-	for (tiny _ = 0; _<n; _++) {
-		char* str = va_arg(args, char*);
+	// Checked before anything is played: a log holds games of one rule set only.
+	ReplayLog log;
+	if (record) {
+		if (!replay_open(&log, record, &cfg.rules)) {
+			fprintf(stderr, "Cannot record to %s: not a replay log of these rules.\n", record);
+			return 1;
+		}
+		cfg.record = &log;
+	}
 
-		#ifdef DEBUG
-			fprintf(stderr, "Concatting string: %s\n", str);
-		#endif
-		if (!str) continue;
-		len += strlen(str);
-	};
-	
-	char* finalstr = malloc(len + 1); // +1 for NULL
-
-	// Restart varargs. Starting without ending causes undefined behaviour.
-	va_end(args);
-	va_start(args, n);
-
-	// va_arg retrieves and casts arg. va_list should not be indexed.
-	for (tiny _ = 0; _<n; _++) {
-		char* str = va_arg(args, char*);
-		if (!str) continue;
-		char f;
-		int c = 0;
-
-		// Read till NULL terminator.
-		do *(finalstr + idx++) = f = *(str + c++); while (f);
-		idx--; // The last 0 also gets added. So we overwrite it in the next loop.
+	SimStats stats;
+	Solver solver;
+	solver_init(&solver, cfg.rules);
+	simulate(&solver, &cfg, &stats);
+	print_simstats(&cfg, &stats);
+	solver_free(&solver);
+	if (record && !replay_close(&log)) {
+		fprintf(stderr, "Cannot write to %s: games are missing.\n", record);
+		return 1;
 	}
-	// *(finalstr + idx) = 0; // NULL terminator of string.
-	va_end(args);
-	return finalstr; 
+	return 0;
 }
 
 // ------------------------------------------------------------------------------------ //
-
-char* trimquotes(const char rawstr[]) {
-	/*
-		Removes the quotes of a rawstring.
-		Useful after the #str macro. 
-
-		@param const char rawstr[]: Raw string, provided by the macro.
-		@return char*:	Trimmed string.
-	*/
-	
-	int len = strlen(rawstr) - 2;
-	char *trimstr = malloc(len + 1);
-
-	for (int i = 1; i <= len; i++) trimstr[i - 1] = rawstr[i];
-	trimstr[len] = 0; // NULL terminator of string.
-
-	cache[ncache++] = trimstr; // Caching for GC.
-	return trimstr; 
-}
-
+//                                 Subsection: Replays                                  //
 // ------------------------------------------------------------------------------------ //
 
-char* emojify(char* rawstr, const char* emoji, char echar) {
+int replay_main(int argc, char* argv[], Clock vclock) {
 	/*
-		Replaces a certain character with provided unicode emoji. 
+		Reads a replay log, written by `--record`. With `--game N`, plays game N back
+		(counting from 0). Without, walks every game and prints totals.
 
-		@param char* rawstr: String in which we wish to replace the emoji.
-		@param const char* emoji:	The Emoji string.
-		@param char echar:	 The character which gets replaced by the emoji.
-		@return char*:		 Emojified string.
+		@param int argc:		Argument count, as passed to main.
+		@param char* argv[]:	Arguments, as passed to main. Clock options already removed.
+		@param Clock vclock:	Clock to play the game back on.
+		@return int:			Exit code.
 	*/
-	
-	int n = strlen(rawstr), ne = strlen(emoji);
-	char *emojified = malloc(n + ne);
-	char c;
-	int r = 0, ef = 0;
-	
-	while (r < n) 
-		if ((c = rawstr[r++]) != echar) emojified[ef++] = c; // Copying char.
-			// Copying emoji.
-		else for (int e = 0; e < ne; e++, ef++) emojified[ef] = emoji[e];
-		 
-	emojified[ef] = 0; // NULL terminated string.
-	
-	cache[ncache++] = emojified; // Caching for GC.
-	return emojified;
-}
-
-// ------------------------------------------------------------------------------------ //
-
-char* strnice(const char* rawstr, FG_COLOR fg, BG_COLOR bg, MODIFIER* mod, tiny nmod) {
-	/*
-		Colorizes and applies special effects to strings.
-		Based on ANSI escape sequences.
-		
-		@param char* rawstr:	Plain String.
-		@param FG_COLOR fg:		ANSI Foreground Color.
-		@param BG_COLOR bg:		ANSI Background Color.
-		@param MODIFIER* mod:	List of ANSI special effects.
-		@return char*:			Colorized string.
-	*/
-
-	// Invalid Case,
-	if (!fg && !bg && !nmod) {
-		char* raw = joinstr(1, rawstr);	
-		cache[ncache++] = raw; // Caching for GC
-		return raw;
+	const char* path = NULL;
+	long long show = -1;
+
+	for (int a = 1; a < argc; a += 2) {
+		const char* val = a + 1 < argc ? argv[a + 1] : NULL;
+		if (!strcmp(argv[a], "--replay") && val) path = val;
+		else if (!strcmp(argv[a], "--game") && val && (show = atoll(val)) >= 0) continue;
+		else {
+			fprintf(stderr, "Invalid argument: %s\n", argv[a]);
+			fprintf(stderr, "Usage: %s --replay FILE [--game N] [--clock real|fast|instant]\n", argv[0]);
+			return 2;
+		}
 	}
 
-	int rawlen = strlen(rawstr);
-	tiny esclen = 3; // \033[m
-
-	// !! converts non-zero value to 1.
-	tiny ncolor = !!fg + !!bg;
-	tiny nsemi = ncolor + nmod - 1;
-
-	// +1 for 0 in \033[0m; +1 for NULL.
-	// \033[1;7;31;42mHello\033[0m
-	char* filled = malloc(esclen*2 + ncolor*2 + nmod + nsemi + rawlen + 1 + 1); 
-	int i = 0, c;
-	char f;
-	filled[i++] = 033;
-	filled[i++] = '[';
-
-	// Add fg and bg colors.
-	if (fg) {
-		char* fgstr = itoa(fg);
-		c = 0;	
-
-		// Copy till NULL terminator.
-		do filled[i++] = f = fgstr[c++]; while (f);
-		filled[i-1] = ';'; // Replace NULL byte 0;
+	ReplayReader reader;
+	if (!replay_map(&reader, path)) {
+		fprintf(stderr, "Cannot read %s: not a replay log.\n", path);
+		return 1;
 	}
 
-	if (bg) {
-		char* bgstr = itoa(bg);
-		c = 0;
-		
-		// Copy till NULL terminator.
-		do filled[i++] = f = bgstr[c++]; while (f);
-		filled[i-1] = ';'; // Last NULL is saved above. So we overwrite it.
+	ReplayGame game;
+	const uint8_t* picks;
+	long long ngames = 0, npicks = 0, wins[2] = {0}, refusals = 0, normies = 0;
+	double start = now_seconds();
+
+	while (replay_next(&reader, &game, &picks)) {
+		if (ngames++ == show) break;
+		npicks += game.npicks;
+		wins[game.winner]++;
+		refusals += game.refused;
+		normies += game.normie;
 	}
 
-	
-	// Deal with modifiers separately.
-	for (short idx = 0; idx < nmod; idx++) {
-		filled[i++] = mod[idx] + '0';
-		filled[i++] = ';';
+	if (show >= 0) {
+		// Drawn from a `Board`, which has room for BOARD_MAX_POOL sticks.
+		int status = 0;
+		if (ngames <= show) fprintf(stderr, "There are only %lld games.\n", ngames), status = 1;
+		else if (reader.rules.pool > BOARD_MAX_POOL) {
+			fprintf(stderr, "Only games of up to %d sticks can be drawn.\n", BOARD_MAX_POOL);
+			status = 1;
+		}
+		else {
+			Session session;
+			session_init(&session, stdin, stdout);
+			session.clock = vclock;
+			replay_show(&session, &reader, &game, picks);
+			session_free(&session);
+		}
+		replay_unmap(&reader);
+		return status;
 	}
 
-	// Replace last ; with m.
-	filled[i - 1] = 'm';
-
-	// Add remaining string. 
-	c = 0;
-	while (c < rawlen) filled[i++] = rawstr[c++];
-
-	// Put closing formatter.
-	filled[i++] = 033;
-	filled[i++] = '[';
-	filled[i++] = '0';
-	filled[i++] = 'm';
-	filled[i++] = 0;
-	
-	cache[ncache++] = filled; // Caching for GC.
-	return filled;
+	double secs = now_seconds() - start;
+	secs = secs > 0 ? secs : 1e-9;
+	double games = ngames ? ngames : 1;
+	printf("games:           %lld\n", ngames);
+	printf("rules:           pool %lld, picks", reader.rules.pool);
+	for (tiny s = 1; s <= 64; s++) if (reader.rules.moves >> (s - 1) & 1) printf(" %d", s);
+	printf(", %s play\n", reader.rules.misere ? "misere" : "normal");
+	printf("bytes:           %zu (%.2f per game)\n", reader.size, reader.size / games);
+	printf("moves/game:      %.3f\n", npicks / games);
+	printf("human wins:      %lld (%.2f%%)\n", wins[HUMAN], 100 * wins[HUMAN] / games);
+	printf("computer wins:   %lld (%.2f%%)\n", wins[COMPUTER], 100 * wins[COMPUTER] / games);
+	printf("refusals:        %lld\n", refusals);
+	printf("normie games:    %lld\n", normies);
+	printf("seconds:         %.3f\n", secs);
+	printf("games/sec:       %.0f\n", ngames / secs);
+	printf("MB/sec:          %.0f\n", reader.size / secs / 1e6);
+	replay_unmap(&reader);
+	return 0;
 }
 
-
 // ------------------------------------------------------------------------------------ //
-//                            Subsection: Memory Management                             //
+//                                Subsection: Tablebases                                //
 // ------------------------------------------------------------------------------------ //
 
-void _gc(void) {
+int tablebase_main(int argc, char* argv[]) {
 	/*
-		Cleares the cached pointers.
-	*/ 
-
-	#ifdef DEBUG
-		fprintf(stderr, "Attempting to clear cache:\n");
-		for (short n = 0; n < ncache; n++) fprintf(stderr, "\t[%d]: %p\n", n, cache[n]);
-	#endif
-	
-	for (short n = 0; n < ncache; n++) {
-		// TODO Memleak here.
-		free(cache[n]);
-		cache[n] = NULL;
+		The tablebase generator. Solves every position of N heaps, saves the table, maps
+		it back and checks it: the single heap positions against the solver, and the file
+		against the table built. Then times lookups of random positions in the mapped file,
+		and checks the same positions against the Grundy values (`grundy_win`).
+
+		@param int argc:		Argument count, as passed to main.
+		@param char* argv[]:	Arguments, as passed to main.
+		@return int:			Exit code.
+	*/
+	const long nprobes = 1000000;
+	const char* path = NULL;
+	Rules rules = CLASSIC_RULES;
+	int nheaps = 3;
+	uint64_t seed = time(0);
+
+	for (int a = 1; a < argc; a += 2) {
+		const char* arg = argv[a];
+		const char* val = a + 1 < argc ? argv[a + 1] : NULL;
+		bool ok = val != NULL;
+
+		if (!strcmp(arg, "--build-tablebase") && ok) path = val;
+		else if (!strcmp(arg, "--heaps") && ok) nheaps = atoi(val), ok = nheaps >= 1 && nheaps <= TABLEBASE_MAX_HEAPS;
+		else if (!strcmp(arg, "--pool") && ok) rules.pool = atoll(val), ok = rules.pool > 0;
+		else if (!strcmp(arg, "--moves") && ok) ok = parse_moves(&rules.moves, val);
+		else if (!strcmp(arg, "--seed") && ok) seed = strtoull(val, NULL, 10);
+		else if (!strcmp(arg, "--normal")) {
+			rules.misere = false;
+			a--; // Takes no value.
+			continue;
+		}
+		else ok = false;
+
+		if (!ok) {
+			fprintf(stderr, "Invalid argument: %s\n", arg);
+			fprintf(stderr, "Usage: %s --build-tablebase FILE [--heaps N] [--pool N] [--moves 1,3,4] "
+				"[--normal] [--seed S]\n\tN heaps of 0 to --pool sticks. Up to %d heaps.\n", 
+				argv[0], TABLEBASE_MAX_HEAPS);
+			return 2;
+		}
 	}
 
-	#ifdef DEBUG
-		fprintf(stderr, "CLEARED CACHE (%d ITEMS)\n", ncache);
-	#endif
-	ncache = 0;
-}
-
-// ------------------------------------------------------------------------------------ //
+	Tablebase built, mapped;
+	double t0 = now_seconds();
+	if (!tablebase_build(&built, rules, nheaps)) {
+		fprintf(stderr, "Too large: %d heaps of %lld sticks. At most %lld positions and %d sticks.\n", 
+			nheaps, rules.pool, TABLEBASE_MAX_POSITIONS, TABLEBASE_MAX_STICKS);
+		return 1;
+	}
+	double t1 = now_seconds();
+	if (!tablebase_save(&built, path) || !tablebase_map(&mapped, path)) {
+		fprintf(stderr, "Cannot write %s.\n", path);
+		tablebase_free(&built);
+		return 1;
+	}
+	bool agree = mapped.size == built.size && !memcmp(mapped.data, built.data, built.size);
+	tablebase_free(&built);
+
+	// One heap is the game the solver plays.
+	Solver solver;
+	solver_init_full(&solver, rules);
+	int heaps[TABLEBASE_MAX_HEAPS] = {0};
+	for (long long n = 0; n <= rules.pool; n++) {
+		heaps[0] = n;
+		agree &= tablebase_win(&mapped, heaps) == !solver_losing(&solver, n);
+	}
+	solver_free(&solver);
 
-void _gc_full_(void) {
-	/*
-		Cleares all pointers in memory. Used before exiting.
-	*/ 
-	_gc();
-	free(modheavy);
-	free(modlight);
-	for (tiny i = 0; i < nMSG; i++) {
-		#ifdef DEBUG
-			fprintf(stderr, "Attempting to free MESSAGES[%i]...\n", i);
-		#endif
-		char* msg = (char*) MESSAGES[i];
-		if (msg) free(msg);
+	long long won = 0, max_dtm = 0;
+	for (long long r = 0; r < mapped.npositions; r++) {
+		int dtm = tablebase_at(&mapped, r);
+		won += (dtm & 1) != rules.misere;
+		if (dtm > max_dtm) max_dtm = dtm;
 	}
 
-	// Hardcoded. Will be modified if changed later.
-	free((void*) DANCES[0]);
-	free((void*) DANCES[1]);
-	free((void*) DANCES[4]);
-	free((void*) DANCES[5]);
+	Rng rng;
+	rng_seed(&rng, seed);
+	double t2 = now_seconds();
+	for (long p = 0; p < nprobes; p++) {
+		for (int h = 0; h < nheaps; h++) heaps[h] = rng_next(&rng) % (rules.pool + 1);
+		tablebase_dtm(&mapped, heaps);
+	}
+	double t3 = now_seconds();
+
+	// Same positions. Misere sums of piles that are not tame have no Grundy rule.
+	Grundy grundy;
+	grundy_init(&grundy, rules);
+	bool grundy_agree = true;
+	long long piles[TABLEBASE_MAX_HEAPS];
+	rng_seed(&rng, seed);
+	for (long p = 0; p < nprobes && grundy.tame; p++) {
+		for (int h = 0; h < nheaps; h++) heaps[h] = piles[h] = rng_next(&rng) % (rules.pool + 1);
+		grundy_agree &= grundy_win(&grundy, piles, nheaps) == tablebase_win(&mapped, heaps);
+	}
+	const char* grundy_column = !grundy.tame ? "-" : grundy_agree ? "yes" : "NO";
+	grundy_free(&grundy);
+
+	printf("# picks");
+	for (tiny s = 1; s <= 64; s++) if (rules.moves >> (s - 1) & 1) printf(" %d", s);
+	printf(", %s play, %s\n", rules.misere ? "misere" : "normal", path);
+	printf("%-6s %9s %12s %12s %10s %12s %12s %8s %6s %9s %7s\n", "heaps", "max_heap", "positions", 
+		"bytes", "build_ms", "won", "lost", "max_dtm", "agree", "probe_ns", "grundy");
+	printf("%-6d %9lld %12lld %12zu %10.3f %12lld %12lld %8lld %6s %9.2f %7s\n", nheaps, rules.pool, 
+		mapped.npositions, mapped.size, (t1 - t0) * 1e3, won, mapped.npositions - won, max_dtm,
+		agree ? "yes" : "NO", (t3 - t2) * 1e9 / nprobes, grundy_column);
+	tablebase_free(&mapped);
+	return agree && grundy_agree ? 0 : 1;
 }
 
+// ------------------------------------------------------------------------------------ //
+//                                Subsection: Retrograde                                //
 // ------------------------------------------------------------------------------------ //
 
-void setmessages(void) {
-	/*
-		Sets the messages that need to be displayed.
-		Basically a declaration, to be performed at the start of main();
-	*/
-		
-	// -------------------------------------------------------------------------------- //
-	//                                 Portion: Dances                                  //
-	// -------------------------------------------------------------------------------- //
+int retrograde_main(int argc, char* argv[]) {
 	/*
-		When the computer wins, it will dance and taunt the player.
-		These strings are used to set said dance poses.
-		Dance Sequence: L R L R P O P O 
-	*/
+		Solves a variant with `retro_solve` on 1, 2, 4... threads, up to `--threads`, and
+		times each. Every solve is checked against the forward one (`retro_solve_dp`), and
+		against the solver when both players have the same picks and may repeat them.
 
-	
-	char* pose_L = joinstr(7*2,
-	                            "_          "     ,              "\n",
-		emojify(trimquotes(R(   " \   O     "   )), SMILE, 'O'), "\n",
-		                        "  ---|---  "     ,              "\n",
-		        trimquotes(R(   "     |   \_"   )),              "\n",
-		                        "     |     "     ,              "\n",
-		        trimquotes(R(   "    / \    "   )),              "\n",
-		        trimquotes(R(   "   /   \   "   )),              "\n"	
-	);
-	char* pose_R = joinstr(7*2,
-		                        "           _"    ,             "\n",
-		emojify(trimquotes(R(   "     O   / "   )), SMILE, 'O'), "\n",
-		                        "  ---|---  "     ,              "\n",
-		        trimquotes(R(   "_/   |     "   )),              "\n",
-		                        "     |     "     ,              "\n",
-		        trimquotes(R(   "    / \    "   )),              "\n",
-		        trimquotes(R(   "   /   \   "   )),              "\n"	
-	);
-	char* pose_P = joinstr(7*2, 
-	                            "_          _"    ,              "\n",
-		emojify(trimquotes(R(   " \   P   / "   )), TONGUE, 'P'),"\n",
-		                        "  ---|---  "     ,              "\n",
-		        trimquotes(R(   "     |     "   )),              "\n",
-		                        "     |     "     ,              "\n",
-		        trimquotes(R(   "    / \    "   )),              "\n",
-		        trimquotes(R(   "   /   \   "   )),              "\n"	
-	);
-	char* pose_O = joinstr(7*2,
-	                            "_          _"    ,              "\n",
-		emojify(trimquotes(R(   " \   O   / "   )), SMILE, 'O'), "\n",
-		                        "  ---|---  "     ,              "\n",
-		        trimquotes(R(   "     |     "   )),              "\n",
-		                        "     |     "     ,              "\n",
-		        trimquotes(R(   "    / \    "   )),              "\n",
-		        trimquotes(R(   "   /   \   "   )),              "\n"	
-	);
-	
-	DANCES[0] = pose_L;
-	DANCES[1] = pose_R;
-	DANCES[2] = pose_L;
-	DANCES[3] = pose_R;
-	
-	DANCES[4] = pose_P;
-	DANCES[5] = pose_O;
-	DANCES[6] = pose_P;
-	DANCES[7] = pose_O;
-
-	// Many objects have built up in cache. Good idea to clear them here.
-	_gc();
-
-	// -------------------------------------------------------------------------------- //
-	//                                Portion: Messages                                 //
-	// -------------------------------------------------------------------------------- //
-	/*
-		Many messages exist in the game that are displayed repeatedly.
-		This will store them.
+		@param int argc:		Argument count, as passed to main.
+		@param char* argv[]:	Arguments, as passed to main.
+		@return int:			Exit code.
 	*/
+	Variant variant = {
+		.pool = 1000000,
+		.moves = {CLASSIC_RULES.moves, CLASSIC_RULES.moves},
+		.misere = CLASSIC_RULES.misere
+	};
+	short maxthreads = count_cores();
+	bool computer_moves = false;
 
-	MESSAGES[emj_smile] = joinstr(1, strnice(":)", FG_GREEN, BG_DEFAULT, modheavy, 1));
-	MESSAGES[emj_happy] = joinstr(1, strnice(":D", FG_GREEN, BG_DEFAULT, modheavy, 1));
-	MESSAGES[emj_angry] = joinstr(1, strnice(">:(", FG_RED, BG_DEFAULT, modheavy, 1));
-	MESSAGES[emj_evil]  = joinstr(1, strnice(">:)", FG_PURPLE, BG_DEFAULT, modheavy, 1));
-	MESSAGES[emj_taunt] = joinstr(1, strnice(":P", FG_YELLOW, BG_DEFAULT, modheavy, 1));
-	MESSAGES[emj_sad]   = joinstr(1, strnice(":(", FG_RED, BG_DEFAULT, modheavy, 1));
-	MESSAGES[emj_cry]   = joinstr(1, strnice(":'(", FG_BLUE, BG_DEFAULT, modheavy, 1));
+	for (int a = 1; a < argc; a += 2) {
+		const char* arg = argv[a];
+		const char* val = a + 1 < argc ? argv[a + 1] : NULL;
+		bool ok = val != NULL;
 
-	#ifdef DEBUG
-		fprintf(stderr, "Saved Emojis.\n");
-		fprintf(stderr, "Like this emoji: %s\n", strnice(":)", FG_GREEN, BG_DEFAULT, modheavy, 1));
-	#endif
+		if (!strcmp(arg, "--retrograde")) {
+			a--; // Takes no value.
+			continue;
+		}
+		else if (!strcmp(arg, "--pool") && ok) variant.pool = atoll(val), ok = variant.pool > 0;
+		else if (!strcmp(arg, "--moves") && ok) ok = parse_moves(&variant.moves[HUMAN], val);
+		else if (!strcmp(arg, "--computer-moves") && ok) 
+			ok = parse_moves(&variant.moves[COMPUTER], val), computer_moves = true;
+		else if (!strcmp(arg, "--threads") && ok) 
+			maxthreads = atoi(val), ok = maxthreads > 0 && maxthreads <= MAX_THREADS;
+		else if (!strcmp(arg, "--no-repeat")) {
+			variant.no_repeat = true;
+			a--; // Takes no value.
+			continue;
+		}
+		else if (!strcmp(arg, "--normal")) {
+			variant.misere = false;
+			a--; // Takes no value.
+			continue;
+		}
+		else ok = false;
+
+		if (!ok) {
+			fprintf(stderr, "Invalid argument: %s\n", arg);
+			fprintf(stderr, "Usage: %s --retrograde [--pool N] [--moves 1,3,4] [--computer-moves 1,2] "
+				"[--no-repeat] [--normal] [--threads N]\n"
+				"\t--moves: picks of both players, or of the human with --computer-moves.\n", argv[0]);
+			return 2;
+		}
+	}
+	if (!computer_moves) variant.moves[COMPUTER] = variant.moves[HUMAN];
 
-	// -------------------------------------------------------------------------------- //
-
-	MESSAGES[greeting] = joinstr(9, 
-		"Hi! Welcome to my game! ", 
-		MESSAGES[emj_smile],
-		"\nLet me explain the rules...\n",
-		"\t1. We have 21 matchsticks in the pool.\n",
-		"\t2. Each player can pick 1,2,3 or 4 matchsticks in their turn.\n",
-		"\t3. The player to pick the last matchstick loses.\n",
-		strnice("Lets Begin! ", FG_GREEN, BG_DEFAULT, modheavy, 0),
-		MESSAGES[emj_happy],
-		"\n"	
-	);
-
-	MESSAGES[alt_greeting] = joinstr(10, 
-		"... \n", 
-		"Let me explain the rules again... ", 
-		MESSAGES[emj_taunt], 
-		"\n",
-		"\t1. We have 21 matchsticks in the pool.\n",
-		"\t2. Each player can pick 1,2,3 or 4 matchsticks in their turn.\n",
-		"\t3. The player to pick the last matchstick loses.\n",
-		strnice("Let's go again! ", FG_GREEN, BG_DEFAULT, modheavy, 0),
-		MESSAGES[emj_taunt],
-		"\n"
-	);
-
-	// -------------------------------------------------------------------------------- //
-	
-	MESSAGES[mode_choice] = joinstr(5,
-		"Choose Mode:",
-		"\n\t0. Exit",
-		"\n\t",
-		strnice("1. Normal Mode", FG_GREEN, BG_WHITE, modlight, 1), 
-		strnice("\n\t2. IMPOSSIBLE MODE\n", FG_RED, BG_DEFAULT, modheavy, 2)
-	);
-
-	MESSAGES[nerfed_mode_choice] = joinstr(3,
-		"Choose Mode:",
-		"\n\t0. Exit",
-		strnice("\n\t2. IMPOSSIBLE MODE\n", FG_RED, BG_DEFAULT, modheavy, 2)
-	);
-
-	MESSAGES[color_choice_msg] = joinstr(8, 
-		"Let us choose our colors...\nMy Color is: ", 
-		strnice("\n\t6. CYAN", FG_CYAN, BG_DEFAULT, modheavy, 1),
-		"\nChoose Yours:",
-		strnice("\n\t1. RED", FG_RED, BG_DEFAULT, modheavy, 1),
-		strnice("\n\t2. GREEN", FG_GREEN, BG_DEFAULT, modheavy, 1),
-		strnice("\n\t3. YELLOW", FG_YELLOW, BG_DEFAULT, modheavy, 1),
-		strnice("\n\t4. BLUE", FG_BLUE, BG_DEFAULT, modheavy, 1),
-		strnice("\n\t5. PURPLE", FG_PURPLE, BG_DEFAULT, modheavy, 1)
-	);
-
-	// -------------------------------------------------------------------------------- //
-
-	MESSAGES[goodbye] = joinstr(7, 
-		MESSAGES[emj_cry], 
-		strnice(" So sorry to say goodbye!\n", FG_BLUE, BG_DEFAULT, modlight, 1),
-		MESSAGES[emj_sad],
-		strnice(" I see that you have work to attend to...\n", FG_RED, BG_DEFAULT, modlight, 1),
-		MESSAGES[emj_happy],
-		strnice(" Hope to see you again!\n", FG_GREEN, BG_DEFAULT, modlight, 1),
-		"Bye~\n"
-	);
-
-	MESSAGES[normie] = joinstr(6, 
-		MESSAGES[emj_taunt], 
-		strnice(" HAHA LOSER!\n", FG_RED, BG_DEFAULT, modheavy, 1),
-		strnice("This game is not for normies.", FG_GREEN, BG_WHITE, modlight, 2),
-		"\n",
-		MESSAGES[emj_evil],
-		strnice("  CHOOSE IMPOSSIBLE MODE OR...", FG_RED, BG_WHITE, modheavy, 2)
-	);
-
-	MESSAGES[guts] = joinstr(2, 
-		MESSAGES[emj_evil],
-		strnice(" Yeah!! Now we're talking! Let's Go!", FG_CYAN, BG_DEFAULT, modheavy, 0)
-	);
-
-	MESSAGES[true_normie] = joinstr(8,
-		MESSAGES[emj_taunt],
-		strnice(" It seems that you ", FG_BLUE, BG_DEFAULT, modlight, 0),
-		strnice("really", FG_RED, BG_DEFAULT, modheavy, 2),
-		strnice(" want to be a ", FG_BLUE, BG_DEFAULT, modlight, 0),
-		strnice("normie", FG_BRIGHT_BLACK, BG_WHITE, modheavy, 2),
-		strnice(" so why would I stop you? ", FG_BLUE, BG_DEFAULT, modlight, 0),
-		MESSAGES[emj_taunt],
-		"\n"
-	);
-	
-	// -------------------------------------------------------------------------------- //
-	
-	MESSAGES[invalid_choice] = joinstr(7, 
-		MESSAGES[emj_sad], 
-		strnice("\nYou chose a wrong input!\n", FG_CYAN, BG_DEFAULT, modheavy, 0),
-		strnice("Please choose again.\n", FG_DEFAULT, BG_DEFAULT, modlight, 1),
-		"\n",
-		MESSAGES[emj_evil],
-		strnice("CHOOSE IMPOSSIBLE MODE OR ...", FG_RED, BG_WHITE, modheavy, 2),
-		"\n"
-	);
-
-	MESSAGES[invalid_choice_guts] = joinstr(4, 
-		MESSAGES[emj_sad], 
-		strnice(" You chose a wrong input!\n", FG_CYAN, BG_DEFAULT, modheavy, 0),
-		strnice("Please choose again.\n", FG_DEFAULT, BG_DEFAULT, modlight, 1),
-		"\n"
-	);
-
-	MESSAGES[good_choice] = joinstr(2,
-		MESSAGES[emj_evil], 
-		strnice(" Good Choice", FG_PURPLE, BG_DEFAULT, modheavy, 1)
-	);
-	
-	MESSAGES[bad_choice] = joinstr(2, 
-		MESSAGES[emj_angry],
-		strnice(" You think you're smart huh?", FG_PURPLE, BG_DEFAULT, modheavy, 1)
-	);
-	
-	MESSAGES[get_out] = joinstr(3,
-		MESSAGES[emj_angry],
-		strnice(" I won't be playing with you.\n", FG_PURPLE, BG_DEFAULT, modheavy, 1),
-		strnice("GET OUT!", FG_RED, BG_DEFAULT, modheavy, 2)
-	);
-
-	// -------------------------------------------------------------------------------- //
-
-	MESSAGES[dance_msg] = joinstr(3,
-		MESSAGES[emj_evil],
-		strnice(" HAHA LOSER!! I WON!", FG_PURPLE, BG_DEFAULT, modheavy, 2),
-		"\n"
-	);
-
-	MESSAGES[replay] = joinstr(3,
-		strnice("Let's Play Again! ", FG_BLUE, BG_DEFAULT, modheavy, 0),
-		MESSAGES[emj_happy],
-		"\n"
-	);
-	
-	MESSAGES[true_normie_win] = joinstr(2,
-		MESSAGES[emj_smile],
-		strnice(" Congrats on your win! You truly deserve it", FG_GREEN, BG_DEFAULT, modlight, 0)
-	);
-
-	MESSAGES[true_normie_loss] = joinstr(4,
-		MESSAGES[emj_taunt],
-		"\n",
-		MESSAGES[emj_evil],
-		strnice("  JUST KIDDING!!!", FG_RED, BG_DEFAULT, modlight, 0)
-	);
-
-	MESSAGES[normie_max] = joinstr(2, 
-		strnice("NORMIE", FG_BRIGHT_BLACK, BG_WHITE, modheavy, 2),
-		"     "
-	);
+	Retro reference;
+	double t0 = now_seconds();
+	if (!retro_solve_dp(&reference, variant)) {
+		fprintf(stderr, "Too large: %lld states do not fit in memory.\n", retro_states(&variant));
+		return 1;
+	}
+	double dp_seconds = now_seconds() - t0;
+	long long nwords = (reference.nstates + 63) / 64, won = 0;
+	for (long long state = 0; state < reference.nstates; state++) 
+		won += reference.winning[state >> 6] >> (state & 63) & 1;
+
+	// Same picks for both, and nothing barred: the solver's game, from either seat.
+	bool agree = true;
+	if (variant.moves[HUMAN] == variant.moves[COMPUTER] && !variant.no_repeat) {
+		Solver solver;
+		solver_init(&solver, (Rules) {variant.pool, variant.moves[HUMAN], variant.misere});
+		for (long long n = 0; n <= variant.pool; n++) {
+			agree &= retro_win(&reference, n, HUMAN, 0) == !solver_losing(&solver, n);
+			agree &= retro_win(&reference, n, COMPUTER, 0) == !solver_losing(&solver, n);
+		}
+		solver_free(&solver);
+	}
+
+	print_picks("# human picks", variant.moves[HUMAN]);
+	print_picks(", computer picks", variant.moves[COMPUTER]);
+	printf("%s, %s play\n", variant.no_repeat ? ", no repeats" : "", variant.misere ? "misere" : "normal");
+	printf("# %lld states, %lld won. 9 bytes per state while solving, 1 bit after.\n", 
+		reference.nstates, won);
+	printf("%-8s %10s %12s %8s %6s\n", "threads", "solve_ms", "Mstates_s", "speedup", "agree");
+	printf("%-8s %10.1f %12.2f %8s %6s\n", "dp", dp_seconds * 1e3, 
+		reference.nstates / dp_seconds / 1e6, "-", agree ? "yes" : "NO");
+
+	double base = 0;
+	for (short nthreads = 1; nthreads; nthreads = nthreads == maxthreads ? 0 
+			: nthreads * 2 > maxthreads ? maxthreads : nthreads * 2) {
+		Retro retro;
+		double start = now_seconds();
+		if (!retro_solve(&retro, variant, nthreads)) {
+			fprintf(stderr, "Too large: %lld states do not fit in memory.\n", retro_states(&variant));
+			retro_free(&reference);
+			return 1;
+		}
+		double seconds = now_seconds() - start;
+		if (nthreads == 1) base = seconds;
+
+		bool same = !memcmp(retro.winning, reference.winning, nwords * sizeof(uint64_t));
+		agree &= same;
+		printf("%-8d %10.1f %12.2f %8.2f %6s\n", nthreads, seconds * 1e3, 
+			retro.nstates / seconds / 1e6, base / seconds, same ? "yes" : "NO");
+		retro_free(&retro);
+	}
+	retro_free(&reference);
+	return agree ? 0 : 1;
 }
 
 // ------------------------------------------------------------------------------------ //
 
-void updatemessage(MESSAGE_IDX idx, char* msg) {
+static void print_picks(const char* who, uint64_t moves) {
 	/*
-		Clears the messages if they exist and puts in a new one.
-
-		@param MESSAGE_IDX idx:	Location of message in array.
-		@param char* msg:		The new message to replace with.
+		@param const char* who:		Printed first.
+		@param uint64_t moves:		Picks. Bit s-1 for s.
 	*/
-	if (MESSAGES[idx]) free((void*) MESSAGES[idx]);
-	MESSAGES[idx] = msg;
+	printf("%s", who);
+	for (tiny s = 1; s <= 64; s++) if (moves >> (s - 1) & 1) printf(" %d", s);
 }
 
 // ------------------------------------------------------------------------------------ //
+//                                Subsection: Benchmarks                                //
+// ------------------------------------------------------------------------------------ //
+/*
+	Timings of the engine, run with `game.bin --bench NAME`. 
+	Output is one whitespace separated row per measurement, for easy diffing.
+*/
 
-void setmessages_customcolor(FG_COLOR player_color, FG_COLOR computer_color){
+void bench_solver(Rules rules, uint64_t seed) {
 	/*
-		Resets messages according to player and computer color.
-		We use the helper `updatemessage` as messages need to be 
-		re-created every time.
-
-		@param FG_COLOR player_color:	Color chosen by player.
-		@param FG_COLOR computer_color:	Color of computer.
-	*/	
-
-	updatemessage(plr_pref_choice, joinstr(4, 
-		"\nDo you want to go first? ", 
-		strnice("\n\t1. YES, I (human) will go first.", 
-			player_color, BG_DEFAULT, modheavy, 1),
-		strnice("\n\t2. NO, You (computer) will go first.", 
-			computer_color, BG_DEFAULT, modheavy, 1),
-		"\n"
-	));
-
-	updatemessage(plr_choice_4, joinstr(2,
-		strnice("Now you get to pick certain number of sticks.\n\t", 
-			player_color, BG_DEFAULT, modheavy, 0),
-		strnice("Valid Choices: 1, 2, 3 or 4.\n", 
-			player_color, BG_DEFAULT, modheavy, 1)
-	));
-
-	updatemessage(plr_choice_3, joinstr(2,
-		strnice("Now you get to pick certain number of sticks.\n\t", 
-			player_color, BG_DEFAULT, modheavy, 0),
-		strnice("Valid Choices: 1, 2 or 3.\n", 
-			player_color, BG_DEFAULT, modheavy, 1)
-	));
-		
-	updatemessage(plr_choice_2, joinstr(2,
-		strnice("Now you get to pick certain number of sticks.\n\t", 
-			player_color, BG_DEFAULT, modheavy, 0),
-		strnice("Valid Choices: 1 or 2.\n", player_color, BG_DEFAULT, modheavy, 1)
-	));
-		
-	updatemessage(plr_choice_1, joinstr(2,
-		strnice("Now you get to pick certain number of sticks.\n\t", 
-			player_color, BG_DEFAULT, modheavy, 0),
-		strnice("Valid Choices: ONLY 1.\n", player_color, BG_DEFAULT, modheavy, 1)
-	));
+		Periodic solver against the brute force DP, for growing pools.
+		Both answer the same random positions, and the answers are compared.
+		The DP is skipped once its table would pass 128 MiB.
 
-	updatemessage(cmp_choice, joinstr(1,
-		strnice("Now it's my turn to choose.\n\t", computer_color, BG_DEFAULT, modheavy, 0)
-	));
-
-};
+		@param Rules rules:		Picks and play of the game. The pool is varied.
+		@param uint64_t seed:	Seed of the positions asked.
+	*/
+	const long nlookups = 1000000;
+	const long long pools[] = {21, 1000, 1000000, 100000000, 1000000000, 1LL << 40, 1LL << 62};
+	long long* positions = malloc(nlookups * sizeof(long long));
+	Rng rng;
+	rng_seed(&rng, seed);
+
+	printf("# picks");
+	for (tiny s = 1; s <= 64; s++) if (rules.moves >> (s - 1) & 1) printf(" %d", s);
+	printf(", %s play\n", rules.misere ? "misere" : "normal");
+	printf("%-20s %-9s %12s %14s %10s %8s %7s\n", 
+		"pool", "method", "init_ms", "table_bytes", "lookup_ns", "period", "agree");
+
+	for (tiny p = 0; p < (tiny) (sizeof(pools) / sizeof(*pools)); p++) {
+		rules.pool = pools[p];
+		for (long i = 0; i < nlookups; i++) {
+			positions[i] = rng_next(&rng) % (rules.pool + 1);
+		}
 
+		Solver periodic, full;
+		bool run_full = rules.pool < (1LL << 30);
+		uint64_t sum_periodic = 0, sum_full = 0; // Checksums. Unsigned: they wrap.
 
-// ------------------------------------------------------------------------------------ //
-//                               Subsection: Terminal I/O                               //
-// ------------------------------------------------------------------------------------ //
+		for (tiny method = 0; method < 2; method++) {
+			if (method == 1 && !run_full) {
+				printf("%-20lld %-9s %12s %14s %10s %8s %7s\n", rules.pool, "dp", "-", "-", "-", "-", "-");
+				continue;
+			}
+			Solver* sv = method ? &full : &periodic;
+			uint64_t* sum = method ? &sum_full : &sum_periodic;
+
+			double t0 = now_seconds();
+			if (method) solver_init_full(sv, rules);
+			else solver_init(sv, rules);
+			double t1 = now_seconds();
+			for (long i = 0; i < nlookups; i++) *sum = *sum * 31 + solver_move(sv, positions[i]);
+			double t2 = now_seconds();
+
+			printf("%-20lld %-9s %12.3f %14lld %10.2f %8lld %7s\n", rules.pool, 
+				method ? "dp" : "periodic", (t1 - t0) * 1e3, sv->nwords * 8, 
+				(t2 - t1) * 1e9 / nlookups, sv->period, 
+				method ? (sum_full == sum_periodic ? "yes" : "NO") : "-");
+		}
 
-tiny getn(void) {
-	/*
-		Reads the first character from stdin and returns it as a tiny.
-
-		@return tiny:	Numeric face value of character entered.
-	*/ 
-	char _, n = getchar();
-	if (n == '\n' || n == EOF) return -1;
-	while ((_ = getchar()) != '\n' && _ != EOF); // FLUSH stdin
-	return n - '0';
+		solver_free(&periodic);
+		if (run_full) solver_free(&full);
+	}
+	free(positions);
 }
 
 // ------------------------------------------------------------------------------------ //
 
-void cls(void){
+void bench_startup(void) {
 	/*
-		Clears the ANSI terminal, using escape sequences.
-		These are the codes decided by ANSI.
-			2J -> CLS;
-			H -> RESET cursor to HOME;
+		Cost of having the messages ready at startup: built at runtime by 
+		`buildmessages`, against the static `MESSAGES` and `DANCES` tables.
+		Also checks that both are the same, byte for byte.
 	*/
-	#ifndef DEBUG
-		fflush(stdout);
-		printf("\033[2J\033[H");
-		fflush(stdout);
-	#endif
+	const int nruns = 2000;
+	const char *messages[nMSG] = {0}, *dances[nDANCES] = {0};
+	Session bench, *session = &bench; // Only its arena and SGR cache are used.
+	session_init(session, stdin, stdout);
+
+	// The static tables cost a start their first access: one read of every byte, before
+	// anything else here touches them.
+	size_t static_before = session->frame_arena.total_allocs;
+	unsigned sum = 0;
+	double s0 = now_seconds();
+	for (tiny i = 0; i < nMSG; i++) for (const char* c = MESSAGES[i]; c && *c; c++) sum += *c;
+	for (tiny i = 0; i < nDANCES; i++) for (const char* c = DANCES[i]; *c; c++) sum += *c;
+	double s1 = now_seconds();
+	size_t nstatic = session->frame_arena.total_allocs - static_before;
+	volatile unsigned sink = sum; // Keeps the reads.
+	(void) sink;
+
+	// Check first.
+	buildmessages(session, messages, dances);
+	bool agree = true;
+	size_t nbytes = 0, nheap = 4; // The 4 distinct dance poses.
+	for (tiny i = 0; i < nMSG; i++) {
+		if (!MESSAGES[i]) continue; // Colored. Built per game.
+		nheap++;
+		nbytes += strlen(MESSAGES[i]) + 1;
+		if (!messages[i] || strcmp(messages[i], MESSAGES[i])) {
+			fprintf(stderr, "MESSAGES[%d] differs from buildmessages.\n", i);
+			agree = false;
+		}
+	}
+	for (tiny i = 0; i < nDANCES; i++) {
+		if (i % 4 < 2) nbytes += strlen(DANCES[i]) + 1; // 0, 1, 4 and 5 are distinct.
+		if (strcmp(dances[i], DANCES[i])) {
+			fprintf(stderr, "DANCES[%d] differs from buildmessages.\n", i);
+			agree = false;
+		}
+	}
+	freemessages(messages, dances);
+	_gc(session);
+
+	size_t arena_before = session->frame_arena.total_allocs;
+	double t0 = now_seconds();
+	for (int r = 0; r < nruns; r++) {
+		buildmessages(session, messages, dances);
+		freemessages(messages, dances);
+		_gc(session);
+	}
+	double t1 = now_seconds();
+	size_t narena = (session->frame_arena.total_allocs - arena_before) / nruns;
+
+	printf("%-9s %14s %12s %13s %8s %6s\n", 
+		"method", "us_per_start", "heap_allocs", "arena_allocs", "bytes", "agree");
+	printf("%-9s %14.3f %12zu %13zu %8zu %6s\n", 
+		"runtime", (t1 - t0) * 1e6 / nruns, nheap, narena, nbytes, "-");
+	// No heap: the tables are laid out by the compiler in read-only data.
+	printf("%-9s %14.3f %12d %13zu %8zu %6s\n", 
+		"static", (s1 - s0) * 1e6, 0, nstatic, nbytes, agree ? "yes" : "NO");
+
+	session_free(session);
 }
 
 // ------------------------------------------------------------------------------------ //
 
-void loading(tiny nloops, const char* loading_txt, const char* dots, bool newln) {
+void bench_render(uint64_t seed) {
 	/*
-		Streams the input. Shows the text and then loads the dots gradually.
-		Fake loading screen.
+		Bytes and time to draw the board each turn: cleared and drawn in full every time,
+		as the game used to, against `draw_board` drawing only what changed.
+		Both draw the same random games of 21 sticks. The output goes to a temporary file.
 
-		@param tiny nloops:		How many times to show the dots / ellipses after deleting.
-		@param const char* loading_txt:		The text that is shown before the ellpises.
-		@param const char* dots:			The ellipses. The dots to stream.
-		@param bool newln:		Whether to append newline at the end.
+		@param uint64_t seed:	Seed of the games.
 	*/
-	if (!nloops) return;
-	tiny ndots = strlen(dots);
-	printf("%s ", loading_txt);
-	fflush(stdout);
-	char load;
-	
-	while (nloops--) {
-		for(tiny i = 0; i < ndots; i++) {
-			load = dots[i];
-			putchar(load);
-			fflush(stdout);
-			#ifndef DEBUG
-				if (load == '.' || (load >= 'A' && load <= 'z')) sleep(1);
-			#endif
+	const int ngames = 20000;
+	const char* names[2] = {"full", "delta"};
+	double bytes[2] = {0};
+
+	printf("%-9s %10s %15s %12s %8s\n", "method", "turns", "bytes_per_turn", "us_per_turn", "ratio");
+	for (tiny method = 0; method < 2; method++) {
+		FILE* out = tmpfile();
+		if (!out) {
+			fprintf(stderr, "Cannot open a temporary file.\n");
+			return;
 		}
+		Session bench, *session = &bench; // Only the frame, the screen and the SGR cache are used.
+		session_init(session, stdin, out);
+		Rng rng;
+		rng_seed(&rng, seed); // Same games for both.
+
+		long turns = 0;
+		double start = now_seconds();
+		for (int g = 0; g < ngames; g++) {
+			Board board = board_new(rng_next(&rng) & 1);
+			FG_COLOR player_color = FG_RED + g % nTHEMES;
+			INF_LOOP {
+				if (!method) cls(session);
+				draw_board(session, board, 21, player_color, FG_CYAN);
+				turns++;
 
-		// ANSI Escape codes to move cursor.
-		// nD = Move n to the left. 0K = Delete from cursor to end of screen.	
-		if (nloops) printf("\033[%hdD\033[0K", ndots), fflush(stdout); 
+				tiny remaining = 21 - board_taken(board);
+				if (!remaining) break;
+				board = board_apply(board, 1 + rng_next(&rng) % (remaining < 4 ? remaining : 4));
+			}
+			fb_flush(session);
+		}
+		double secs = now_seconds() - start;
+
+		bytes[method] = (double) session->screen.bytes / turns;
+		printf("%-9s %10ld %15.1f %12.3f %8.2f\n", names[method], turns, bytes[method], 
+			secs * 1e6 / turns, bytes[0] / bytes[method]);
+		session_free(session);
+		fclose(out);
 	}
-	if (newln) putchar('\n'), fflush(stdout);
 }
 
 // ------------------------------------------------------------------------------------ //
 
-void printsticks(tiny choices[21], tiny choice_sum, FG_COLOR player_color, FG_COLOR computer_color) {
+void bench_sgr(uint64_t seed) {
 	/*
-		Used to print the sticks selected & remaining.
-		Colors them as necessary.
-	
-		@param tiny choices[21]:		Choices of the player / computer.
-		@param tiny choice_sum:			Sum of all choices.
-		@param FG_COLOR player_color:	Color that describes the player.
-		@param FG_COLOR computer_color:	Color that describes the computer.
-	*/
-		
-	tiny cidx = 0, baridx = 0, choice;
-	char *bars;
-		
-	while ((choice = choices[cidx]) && cidx < 21) {
-		char bar; // Bar to use for current choice. Computer uses \, Player /, Unused |
-		
-		// Read masked bit to determine choice.
-		FG_COLOR color_choice = choice & 0b1000 ? (bar='\\', computer_color) : (bar='/', player_color);
-		choice &= 0b111; // Reject mask.
+		Bytes saved by the SGR filter, and how fast it filters, on two inputs:
+		every message of the game in every theme, as stored in the tables, and the frames 
+		of a real game (impossible mode, red, picking 1 every turn).
+		The game is played twice with the same seed: filtered frame by frame, as on a 
+		terminal, for the bytes, and unfiltered, to have raw frames to time the filter on.
 
-		bars = malloc(choice + 1);
-		for(baridx = 0; baridx < choice; baridx++) bars[baridx] = bar;
-		bars[baridx] = 0; // NULL terminator.
-		
-		printf(strnice(bars, color_choice, BG_DEFAULT, modheavy, 0));
+		@param uint64_t seed:	Seed of the game.
+	*/
+	const long min_bytes = 64L << 20; // Filtered per timing.
+	const char* script = "2\n1\n1\n1\n\n1\n\n1\n\n1\n\n1\n0\n";
+	const char* names[2] = {"messages", "game"};
+	FILE* raw[2] = {tmpfile(), tmpfile()};
+	FILE *in = tmpfile(), *out = tmpfile();
+	size_t bytes_out[2] = {0};
+	if (!raw[0] || !raw[1] || !in || !out) {
+		fprintf(stderr, "Cannot open a temporary file.\n");
+		return;
+	}
 
-		cidx++; // Next choice.
-		free(bars);
+	// The static table, the dances, and the colored messages of each theme.
+	Session bench, *session = &bench;
+	session_init(session, stdin, stdout);
+	for (tiny i = 0; i < nMSG; i++) if (MESSAGES[i]) fputs(MESSAGES[i], raw[0]);
+	for (tiny i = 0; i < nDANCES; i++) fputs(DANCES[i], raw[0]);
+	for (tiny t = 0; t < nTHEMES; t++) {
+		for (tiny i = plr_pref_choice; i <= cmp_choice; i++) fputs(getmessage(session, t, i), raw[0]);
+	}
+	session_free(session);
+
+	// The game. Input is scripted and waits take no time.
+	fputs(script, in);
+	for (tiny filtered = 1; filtered >= 0; filtered--) {
+		rewind(in);
+		session_init(session, in, filtered ? out : raw[1]);
+		session->clock = (Clock) {.mode = CLK_INSTANT, .frame_ms = FRAME_MS};
+		session->noplay_path = session->normie_path = NULL;
+		session->sgr.enabled = filtered;
+		rng_seed(&session->rng, seed);
+		session_run(session);
+		session_free(session);
+		if (filtered) bytes_out[1] = session->sgr.bytes_out;
 	}
 
-	// Unused bars.
-	bars = malloc(21 - choice_sum + 1);	
-	for(baridx = 0; baridx < 21 - choice_sum; baridx++) bars[baridx] = '|';
-	bars[baridx] = 0; // NULL Terminator.
-	puts(bars);
-	free(bars);
-	_gc();
-}
+	printf("%-9s %10s %10s %8s %10s\n", "input", "bytes_in", "bytes_out", "saved%", "MB_per_s");
+	for (tiny k = 0; k < 2; k++) {
+		size_t len = ftell(raw[k]);
+		char* data = malloc(len);
+		rewind(raw[k]);
+		if (!data || fread(data, 1, len, raw[k]) != len) {
+			fprintf(stderr, "Cannot read back the %s.\n", names[k]);
+			return;
+		}
 
-// ------------------------------------------------------------------------------------ //
+		SgrFilter filter = {.enabled = true};
+		if (!k) bytes_out[0] = sgr_filter(&filter, data, len); // All in one frame.
 
-void dance(const char* message, tiny nloop) {
-	/*
-		Simple implementation of dancing mechanism.
-		
-		@param char* message:	Message to show above dancing man.
-		@param tiny nloop: 		Number of times to loop dance.
-	*/
-	
-	while (nloop--) {	
-		for (int i = 0; i<nDANCES; i++) {
-			cls();
-			puts(message);
-			puts(DANCES[i]);
-			fflush(stdout);
-			sleep(1);
-		}
-		cls();
+		long nruns = min_bytes / len + 1;
+		double start = now_seconds();
+		for (long r = 0; r < nruns; r++) sgr_filter(&filter, data, len);
+		double secs = now_seconds() - start;
+
+		printf("%-9s %10zu %10zu %8.1f %10.1f\n", names[k], len, bytes_out[k], 
+			100.0 * (len - bytes_out[k]) / len, nruns * len / secs / 1e6);
+		sgr_filter_free(&filter);
+		free(data);
+		fclose(raw[k]);
 	}
+	fclose(in);
+	fclose(out);
 }
 
 // ------------------------------------------------------------------------------------ //
-// ------------------------------------------------------------------------------------ //
-
-
-
-// ==================================================================================== //
-//                          Function Implementations - Primary                          //
-// ==================================================================================== //
 
+static double bench_mark(Arena* arena, size_t mark[2]) {
+	/*
+		Starts measuring a helper: notes the arena's lifetime counters and the time.
 
-// ------------------------------------------------------------------------------------ //
-//                                  Subsection: Logic                                   //
-// ------------------------------------------------------------------------------------ //
+		@param Arena* arena:	Arena the helper allocates from.
+		@param size_t mark[2]:	Filled with the allocations and bytes so far.
+		@return double:			Now, in seconds.
+	*/
+	mark[0] = arena->total_allocs;
+	mark[1] = arena->total_bytes;
+	return now_seconds();
+}
 
-void REFUSE(void) {
+static void bench_row(const char* helper, Arena* arena, const size_t mark[2], double start, 
+		long nops, size_t heap_allocs, size_t heap_bytes) {
 	/*
-		REFUSE to play with the player.
-		Persistence is implemented using simple file I/O but can be extended.
+		Prints one row of `--bench helpers`: what was allocated since `bench_mark`, per call.
+
+		@param const char* helper:	Name of the helper.
+		@param Arena* arena:		Arena the helper allocates from.
+		@param const size_t mark[2]:	From `bench_mark`.
+		@param double start:		From `bench_mark`.
+		@param long nops:			Calls made.
+		@param size_t heap_allocs:	Allocations made with `malloc`, in all. Not seen by the arena.
+		@param size_t heap_bytes:	Bytes of those.
 	*/
+	double secs = now_seconds() - start;
+	printf("%-13s %10ld %10.1f %14.3f %13.1f\n", helper, nops, secs * 1e9 / nops,
+		(double) (arena->total_allocs - mark[0] + heap_allocs) / nops, 
+		(double) (arena->total_bytes - mark[1] + heap_bytes) / nops);
+}
 
-	char* no = strnice("no", FG_RED, BG_DEFAULT, modheavy, 1);
-	char* no_caps = strnice("NO", FG_RED, BG_DEFAULT, modheavy, 1);
-	char* no_max = strnice("NO!  ", FG_RED, BG_DEFAULT, modheavy, 1);
-
-	puts("");
-	loading(1, no, ".....", true);
-	sleep(1);
-	loading(1, no_caps, "..........", true);
-	sleep(1);
-
-	for (unsigned short n = 10000; n--;) {
-		printf(no_max);
-	};
-	puts("");
-
-	// Persistence: This enables us to REFUSE whenever player has won once.
-	FILE* noplay = fopen("./noplay", "w");
-	fputs("0", noplay);
-	fclose(noplay);
-
-	// GC;
-	_gc_full_();
-
-	cls();
-	exit(0);
-};
-
-// ------------------------------------------------------------------------------------ //
-
-void NORMIE(void) {
+void bench_helpers(uint64_t seed) {
 	/*
-		Callout the NORMIE!!
-		Persistence is implemented using simple file I/O but can be extended.
+		Time, allocations and bytes per call of the string and render helpers, 
+		on the inputs the game gives them: the stick counters, the pieces of the messages
+		and of the dance poses, the styled strings and the boards of random games.
+		Arena allocations are counted by the frame arena, rounded up as it rounds them.
+		`malloc`s are counted from the strings returned. The frame arena is reset after 
+		every pass over the inputs, as the game does every frame.
+		`buildmessages` stands for the whole table, as built at startup before.
+
+		@param uint64_t seed:	Seed of the boards.
 	*/
-	const char* normax = MESSAGES[normie_max];
-	loading(1, "You, you are a ", normax, true);
-	for (unsigned short n = 10000; n--;) {
-		printf(normax);
+	const long nops = 1000000; // Calls per helper, rounded up to whole passes.
+	const int nbuilds = 2000;
+	Session bench, *session = &bench; // Only its arena, SGR cache and frame are used.
+	session_init(session, stdin, stdout);
+	Arena* arena = &session->frame_arena;
+	size_t mark[2], heap_allocs, heap_bytes;
+	double start;
+	long n;
+
+	// Inputs. The raw lines and heads of the dance poses, as `buildmessages` has them.
+	const char* raws[] = {
+		R(   " \   O     "   ), R(   "     O   / "   ), R(   " \   P   / "   ), 
+		R(   "     |   \_"   ), R(   "_/   |     "   ), R(   "     |     "   ), 
+		R(   "    / \    "   ), R(   "   /   \   "   )
 	};
-	puts("");
-
-	// Persistence: This enables us to REFUSE whenever player has won once.
-	FILE* norfile = fopen("./normie", "w");
-	fputs("0", norfile);
-	fclose(norfile);
-
-	// GC
-	_gc_full_();
-	cls();
-	exit(0);
-};
-
-// ------------------------------------------------------------------------------------ //
-
-tiny computer_choose(tiny choice_sum, bool random) {
-	/*
-		Algorithm for the best possible choice.
+	const tiny nraws = sizeof(raws) / sizeof(*raws);
+	char heads[3][16] = {" \\   O     ", "     O   / ", " \\   P   / "};
+	const char* emojis[3] = {SMILE, SMILE, TONGUE};
+	const char echars[3] = {'O', 'O', 'P'};
+	
+	// Styled pieces of the messages.
+	const struct { 
+		const char* str; 
+		FG_COLOR fg; 
+		BG_COLOR bg; 
+		const MODIFIER* mod; 
+		tiny nmod; 
+	} styled[] = {
+		{":)", FG_GREEN, BG_DEFAULT, modheavy, 1},
+		{">:)", FG_PURPLE, BG_DEFAULT, modheavy, 1},
+		{"Lets Begin! ", FG_GREEN, BG_DEFAULT, modheavy, 0},
+		{"1. Normal Mode", FG_GREEN, BG_WHITE, modlight, 1},
+		{"\n\t2. IMPOSSIBLE MODE\n", FG_RED, BG_DEFAULT, modheavy, 2},
+		{"\n\t4. BLUE", FG_BLUE, BG_DEFAULT, modheavy, 1}
+	};
+	const tiny nstyled = sizeof(styled) / sizeof(*styled);
+
+	// Positions of random games of 21 sticks, as drawn at the top of the screen.
+	enum { nBOARDS = 64 };
+	Board boards[nBOARDS];
+	Rng rng;
+	rng_seed(&rng, seed);
+	for (tiny b = 0; b < nBOARDS; b++) {
+		boards[b] = board_new(rng_next(&rng) & 1);
+		tiny stop = rng_next(&rng) % 22, remaining;
+		while ((remaining = 21 - board_taken(boards[b])) > 21 - stop) {
+			boards[b] = board_apply(boards[b], 1 + rng_next(&rng) % (remaining < 4 ? remaining : 4));
+		}
+	}
 
-		@param tiny choice_sum:	Current Sum of all choices made by both players.
-		@return tiny:			Next choice of computer.
-	*/
+	printf("%-13s %10s %10s %14s %13s\n", "helper", "ops", "ns_per_op", "allocs_per_op", "bytes_per_op");
 
+	start = bench_mark(arena, mark);
+	for (n = 0; n < nops; n += 21) {
+		for (tiny i = 1; i <= 21; i++) itoa(session, i);
+		arena_reset(arena);
+	}
+	bench_row("itoa", arena, mark, start, n, 0, 0);
+
+	// The greeting, a long message, and the mode choice, a short one.
+	heap_allocs = heap_bytes = 0;
+	start = bench_mark(arena, mark);
+	for (n = 0; n < nops; n += 2) {
+		char* long_msg = joinstr(9, 
+			"Hi! Welcome to my game! ", MESSAGES[emj_smile], "\nLet me explain the rules...\n",
+			"\t1. We have 21 matchsticks in the pool.\n",
+			"\t2. Each player can pick 1,2,3 or 4 matchsticks in their turn.\n",
+			"\t3. The player to pick the last matchstick loses.\n",
+			"Lets Begin! ", MESSAGES[emj_happy], "\n");
+		char* short_msg = joinstr(3, "Choose Mode:", "\n\t0. Exit", "\n\t2. IMPOSSIBLE MODE\n");
+		heap_allocs += 2;
+		heap_bytes += strlen(long_msg) + 1 + strlen(short_msg) + 1;
+		free(long_msg);
+		free(short_msg);
+	}
+	bench_row("joinstr", arena, mark, start, n, heap_allocs, heap_bytes);
+
+	start = bench_mark(arena, mark);
+	for (n = 0; n < nops; n += 2) {
+		arena_joinstr(arena, 9, 
+			"Hi! Welcome to my game! ", MESSAGES[emj_smile], "\nLet me explain the rules...\n",
+			"\t1. We have 21 matchsticks in the pool.\n",
+			"\t2. Each player can pick 1,2,3 or 4 matchsticks in their turn.\n",
+			"\t3. The player to pick the last matchstick loses.\n",
+			"Lets Begin! ", MESSAGES[emj_happy], "\n");
+		arena_joinstr(arena, 3, "Choose Mode:", "\n\t0. Exit", "\n\t2. IMPOSSIBLE MODE\n");
+		arena_reset(arena);
+	}
+	bench_row("arena_joinstr", arena, mark, start, n, 0, 0);
 
-	srand(time(0)); // SEED random.
-	tiny max = (21 - choice_sum < 4) ? 21 - choice_sum : 4;
-	tiny target, tidx = 0;
-	tiny random_choice = rand() % max + 1;
+	start = bench_mark(arena, mark);
+	for (n = 0; n < nops; n += nraws) {
+		for (tiny i = 0; i < nraws; i++) trimquotes(session, raws[i]);
+		arena_reset(arena);
+	}
+	bench_row("trimquotes", arena, mark, start, n, 0, 0);
 
-	// NORMIE
-	if (random) return random_choice;
+	start = bench_mark(arena, mark);
+	for (n = 0; n < nops; n += 3) {
+		for (tiny i = 0; i < 3; i++) emojify(session, heads[i], emojis[i], echars[i]);
+		arena_reset(arena);
+	}
+	bench_row("emojify", arena, mark, start, n, 0, 0);
 
-	// NOT NORMIE
-	if (choice_sum == 20) REFUSE(); // Computer is about to lose.
-	
-	// Find the next target.
-	while (tidx < 5 && (target = (tiny) TARGETS[tidx]) <= choice_sum) tidx++;
-	
-	tiny choice = target - choice_sum;
-	if (choice >= 5) {
-		printf(MESSAGES[emj_angry]);
-		return random_choice;
+	start = bench_mark(arena, mark);
+	for (n = 0; n < nops; n += nstyled) {
+		for (tiny i = 0; i < nstyled; i++) {
+			strnice(session, styled[i].str, styled[i].fg, styled[i].bg, styled[i].mod, styled[i].nmod);
+		}
+		arena_reset(arena);
 	}
+	bench_row("strnice", arena, mark, start, n, 0, 0);
+
+	// Draws into the frame, which is thrown away: only the drawing is measured.
+	start = bench_mark(arena, mark);
+	for (n = 0; n < nops; n += nBOARDS) {
+		for (tiny b = 0; b < nBOARDS; b++) {
+			printsticks(session, boards[b], 21, FG_RED + b % nTHEMES, FG_CYAN);
+			session->frame.len = 0;
+		}
+	}
+	bench_row("printsticks", arena, mark, start, n, 0, 0);
+
+	// Every message and the 4 distinct dance poses are on the heap.
+	const char *messages[nMSG] = {0}, *dances[nDANCES] = {0};
+	buildmessages(session, messages, dances);
+	size_t build_allocs = 0, build_bytes = 0;
+	for (tiny i = 0; i < nMSG; i++) if (messages[i]) build_allocs++, build_bytes += strlen(messages[i]) + 1;
+	for (tiny i = 0; i < nDANCES; i++) if (i % 4 < 2) build_allocs++, build_bytes += strlen(dances[i]) + 1;
+	freemessages(messages, dances);
+	arena_reset(arena);
+
+	start = bench_mark(arena, mark);
+	for (n = 0; n < nbuilds; n++) {
+		buildmessages(session, messages, dances);
+		freemessages(messages, dances);
+		arena_reset(arena);
+	}
+	bench_row("buildmessages", arena, mark, start, n, n * build_allocs, n * build_bytes);
 
-	printf(MESSAGES[emj_evil]);
-	return choice;
+	session_free(session);
 }
 
-
-// ------------------------------------------------------------------------------------ //
-//                               Subsection: Subroutines                                //
 // ------------------------------------------------------------------------------------ //
 
-void wrong_input(bool guts) {
-	/* 
-		#subroutine
-		Error message shown to user when invalid option chosen.
+void bench_grundy(Rules rules) {
+	/*
+		Grundy values of every pile up to 10^8 sticks: one value at a time from the table
+		(`grundy_init_scalar`), against the 64-bit windows of `grundy_init`.
+		Both tables are compared, byte for byte.
 
-		@param bool guts:	Whether player has guts (i.e. has chosen Impossible mode).
+		@param Rules rules:		Picks and play of the game. The pool is varied.
 	*/
-	cls();
-	printf(MESSAGES[guts ? invalid_choice_guts : invalid_choice]);
-	sleep(3);
-	cls();
-}
-
-// ------------------------------------------------------------------------------------ //
+	const long long pools[] = {1000000, 10000000, 100000000};
+	const char* names[2] = {"scalar", "bitset"};
+
+	printf("# picks");
+	for (tiny s = 1; s <= 64; s++) if (rules.moves >> (s - 1) & 1) printf(" %d", s);
+	printf(", %s play\n", rules.misere ? "misere" : "normal");
+	printf("%-12s %-8s %10s %10s %8s %8s %7s %6s\n", 
+		"pool", "method", "init_ms", "ns_per_pile", "speedup", "max", "tame", "agree");
+
+	for (tiny p = 0; p < (tiny) (sizeof(pools) / sizeof(*pools)); p++) {
+		rules.pool = pools[p];
+		Grundy built[2];
+		double secs[2];
+		for (tiny method = 0; method < 2; method++) {
+			double start = now_seconds();
+			if (method) grundy_init(&built[method], rules);
+			else grundy_init_scalar(&built[method], rules);
+			secs[method] = now_seconds() - start;
+		}
 
-void normal_mode(void) {
-	/* 
-		#subroutine
-		Function to run when `normal` is chosen by user.
-	*/
-	
-	// Mask the bits.
-	// If player enters normal_mode 5 times (despite program saying it doesn't exist)
-	// Player actually gets to play normal mode.
-	if (!normieness) normieness = 1;
-	normieness <<= 1;
-	if (normieness & 0b100000) {
-		normieness >>= 1; // Once a normie, always a normie.
-		return impossible_mode(true);
+		bool agree = !memcmp(built[0].values, built[1].values, rules.pool + 1) && (!rules.misere 
+			|| !memcmp(built[0].misere_values, built[1].misere_values, rules.pool + 1));
+		for (tiny method = 0; method < 2; method++) {
+			printf("%-12lld %-8s %10.1f %10.3f %8.2f %8d %7s %6s\n", rules.pool, names[method], 
+				secs[method] * 1e3, secs[method] * 1e9 / (rules.pool + 1), secs[0] / secs[method], 
+				built[method].max_value, built[method].tame ? "yes" : "no", 
+				method ? (agree ? "yes" : "NO") : "-");
+		}
+		grundy_free(&built[0]);
+		grundy_free(&built[1]);
 	}
-	else if (normieness & 0b011100) return wrong_input(false);
-	
-	cls();
-	loading(3, "Loading Normal Mode sources", "...", true);
-	loading(1, "Normalizing Vectors", "...", true);
-	loading(1, "Finding Normals of all circles in sight", "...", true);
-	loading(5, "Running Heavy (but normal) Code", "...", true);
-	loading(1, "Almost There", "........", true);
-	sleep(1);
-	cls();
-	sleep(3);
-	printf(MESSAGES[normie]);
-	sleep(7);
-	cls();
 }
 
 // ------------------------------------------------------------------------------------ //
 
-void impossible_mode(bool is_true_normie) {
-	/* 
-		#subroutine
-		Function to run when `impossible` is chosen by user.
-		This ensures computer always(?) wins.
-	*/
-
-	if (is_true_normie) {
-		puts(MESSAGES[true_normie]);
-		sleep(4);
-		cls();
-	}
+void bench_strategies(Rules rules, uint64_t seed) {
+	/*
+		Every strategy picks in the same random positions, one after the other, keeping its
+		tables between picks as in a game. Prints nodes searched per second, percentiles
+		of the time per pick, and how often it found the winning pick when there was one.
+		`alphabeta` gets 1 ms per pick here, `human` looks SEARCH_HUMAN_DEPTH plies ahead.
 
-	cls();
-	if (!is_true_normie) {
-		puts(MESSAGES[guts]);
-		loading(1,strnice("LOADING IMPOSSIBLE MODE", FG_PURPLE, BG_DEFAULT, modheavy, 1), "......", 1);
-		sleep(2);
-		_gc();
+		@param Rules rules:		Rules to play.
+		@param uint64_t seed:	Of the positions, the random picks and the Zobrist keys.
+	*/
+	const long npicks = 2000;
+	const long long budget_ns = 1000000;
+	const char* names[] = {"table", "alphabeta", "human"};
+	long long* latency = malloc(npicks * sizeof(long long));
+	if (!latency) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
 	}
-	cls();
 
-	
-	tiny choices[21] = {0}, choice_sum = 0, cidx = 0;
-	tiny color_choice, plrchoice; 
-	bool start_with_computer;
-	PLAYER currentplr;
-
-	// Player selects color.
-	INF_LOOP {
-		puts(MESSAGES[color_choice_msg]);
-		#ifdef DEBUG
-			fprintf(stderr, "HERE\n");
-		#endif
-		printf("Choice: ");
-		color_choice = getn();
-		if (color_choice > 0 && color_choice <= 5) break;
-		else wrong_input(true); 
-	}
+	Solver solver;
+	solver_init(&solver, rules);
+
+	printf("# picks");
+	for (tiny s = 1; s <= 64; s++) if (rules.moves >> (s - 1) & 1) printf(" %d", s);
+	printf(", %s play, pool %lld, %ld picks\n", rules.misere ? "misere" : "normal", rules.pool, npicks);
+	printf("%-10s %12s %10s %9s %9s %9s %9s %7s %6s\n", "strategy", "nodes", "Mnodes_s", 
+		"p50_us", "p90_us", "p99_us", "max_us", "depth", "best");
+
+	for (tiny k = 0; k < (tiny) (sizeof(names) / sizeof(*names)); k++) {
+		Strategy strategy;
+		bool ok = k == 0 ? (strategy_table(&strategy, &solver), true)
+			: k == 1 ? strategy_alphabeta(&strategy, rules, budget_ns, seed) 
+			: strategy_human(&strategy, rules, SEARCH_HUMAN_DEPTH, seed);
+		if (!ok) {
+			printf("%-10s Pool too large: at most %d sticks.\n", names[k], SEARCH_MAX_POOL);
+			continue;
+		}
 
-	FG_COLOR player_color = color_choice + 30;
-	FG_COLOR computer_color = FG_CYAN;
-	setmessages_customcolor(player_color, computer_color);
-
-	// Player order preference. Whether player or computer goes first.
-	pref_loop: INF_LOOP {
-		puts(MESSAGES[plr_pref_choice]);
-		printf("Choice: ");
-		start_with_computer = getn() - 1;
-		switch((tiny) start_with_computer) {
-			case HUMAN:
-			case COMPUTER:
-				break pref_loop;
-			default:
-				wrong_input(true);
-				break;
+		Rng positions, picks;
+		rng_seed(&positions, seed);
+		rng_seed(&picks, seed + 1);
+		long won = 0, found = 0;
+		long long total = 0, depths = 0;
+		for (long p = 0; p < npicks; p++) {
+			long long remaining = 1 + rng_next(&positions) % rules.pool;
+			long long start = monotonic_ns();
+			tiny pick = strategy_pick(&strategy, remaining, 0, &picks); // Nothing picked before.
+			latency[p] = monotonic_ns() - start;
+			total += latency[p];
+			depths += strategy.depth;
+
+			if (!solver_losing(&solver, remaining)) {
+				won++;
+				found += pick && solver_losing(&solver, remaining - pick);
+			}
 		}
-	}
 
-	if (!is_true_normie) {
-		if (start_with_computer) puts(MESSAGES[bad_choice]);
-		else puts(MESSAGES[good_choice]);
-		sleep(2);
+		qsort(latency, npicks, sizeof(long long), compare_ns);
+		printf("%-10s %12lld %10.2f %9.2f %9.2f %9.2f %9.2f %7.1f %5.1f%%\n", names[k], strategy.nodes, 
+			strategy.nodes * 1e3 / (total ? total : 1), latency[npicks / 2] / 1e3, 
+			latency[npicks * 9 / 10] / 1e3, latency[npicks * 99 / 100] / 1e3, latency[npicks - 1] / 1e3, 
+			(double) depths / npicks, won ? 100.0 * found / won : 100.0);
+		strategy_free(&strategy);
 	}
-	
-	currentplr = (start_with_computer ? COMPUTER : HUMAN); // Unnecessary but discrete.
-	while (choice_sum < 21) {
-		cls();
-		if (currentplr == HUMAN) {
-			tiny remaining = 21 - choice_sum;
+	solver_free(&solver);
+	free(latency);
+}
 
-			// Get player choice.
-			INF_LOOP {
-				#ifdef DEBUG 
-					printf("Sticks Collected: %d\t", choice_sum);
-				#endif
-				printf("Sticks Remaining: %d\t\t\t\tSticks:\t", remaining);
-				printsticks(choices, choice_sum, player_color, computer_color);
-				puts("");
-
-				// Prompt w/ valid choices.
-				if (remaining == 3) puts(MESSAGES[plr_choice_3]);
-				else if (remaining == 2) puts(MESSAGES[plr_choice_2]);
-				else if (remaining == 1) puts(MESSAGES[plr_choice_1]);
-				else puts(MESSAGES[plr_choice_4]);
-
-				printf("Choice: ");
-				plrchoice = getn();
-
-				if (plrchoice <= 0 || plrchoice > 4 || plrchoice + choice_sum > 21) {
-					wrong_input(true); 
-					cls(); 
-					continue;
-				}
-				break;
-			}
+// ------------------------------------------------------------------------------------ //
 
-			choices[cidx++] = plrchoice;
-			choice_sum += plrchoice;
+static int compare_ns(const void* a, const void* b) {
+	/*
+		For qsort: ascending times.
+	*/
+	long long x = *(const long long*) a, y = *(const long long*) b;
+	return (x > y) - (x < y);
+}
 
-			// Switch Player
-			currentplr = !currentplr; 
-			
-		} else if (currentplr == COMPUTER) {
-			printf("Sticks Remaining: %d\t\t\t\tSticks:\t", 21 - choice_sum);
-			printsticks(choices, choice_sum, player_color, computer_color);
-			puts("");
-			printf(MESSAGES[cmp_choice]);
-
-			char* ichoose = strnice("I Choose", computer_color, BG_DEFAULT, modheavy, 0);
-			plrchoice = computer_choose(choice_sum, is_true_normie); // May REFUSE if needed. Random for normies.
-			puts("");
-			loading(1, ichoose, ".....", false);
-			printf(" %s", strnice(itoa(plrchoice), computer_color, BG_DEFAULT, modheavy, 1));
-
-			// Hide the user input.
-			printf("\nPress Enter to continue...\033[%hdm", HIDE);
-			getn(); // FLUSH
-			puts("\033[0m");
-
-			choices[cidx++] = plrchoice | 0b1000; // MASKing computer inputs.
-			choice_sum += plrchoice;
-
-			// Switch Player
-			currentplr = !currentplr;
-			
-			// We are creating strings here; good idea to GC. 
-			_gc();
-		}
-	}
+// ------------------------------------------------------------------------------------ //
+//                                 Subsection: Metrics                                  //
+// ------------------------------------------------------------------------------------ //
+/*
+	`--metrics FILE`: the game's metrics are appended to FILE, one JSON line per dump,
+	when the game ends and whenever the process gets SIGUSR1 (`kill -USR1 PID`).
+	See `Subsection: Metrics` of matchsticks.c.
+*/
 
-	
-	if (choice_sum == 21 && currentplr == COMPUTER) {
-		// Computer has won! 
-		dance(MESSAGES[dance_msg], 3);
-		puts(MESSAGES[replay]);
-		loading(1,"Resetting", "...", true);
-		_gc();
-		cls();
-	} else if (choice_sum == 21 && currentplr == HUMAN) {
-		loading(1, MESSAGES[true_normie_win], "..........", true);
-		cls();
-		sleep(1);
-		puts(MESSAGES[true_normie_loss]);
-		sleep(2);
-		NORMIE();
-	}
+static volatile sig_atomic_t* metrics_flag; // `metrics.dump` of the game being played.
+
+static void on_sigusr1(int sig) {
+	/*
+		Asks the game for a dump. It writes it itself, at its next step: fprintf
+		is not safe in a signal handler.
+	*/
+	(void) sig;
+	*metrics_flag = 1;
 }
+
 // ------------------------------------------------------------------------------------ //
 // ------------------------------------------------------------------------------------ //
 
@@ -1442,82 +1268,121 @@ void impossible_mode(bool is_true_normie) {
 // |==================================================================================| //
 // |==================================================================================| //
 
-int main(void) {
+int main(int argc, char* argv[]) {
 
 	#ifdef DEBUG
 		fprintf(stderr, "DEBUG MODE ON.\n");
 	#endif
 
-	// Initialization
-	modheavy = malloc(sizeof(MODIFIER) * 2);
-	*modheavy = BOLD;
-	modheavy[1] = UNDERLINE;
-		
-	modlight = malloc(sizeof (MODIFIER) * 2);
-	*modlight = FAINT;
-	modlight[1] = STRIKE;
-
-	setmessages();
-
-	// If said file exists, then computer will REFUSE to play.
-	FILE* noplay = fopen("./noplay", "r");
-	if (noplay) {
-		fclose(noplay);
-		cls();
-		sleep(1);
-		puts(MESSAGES[get_out]);
-		sleep(5);
-		cls();
-		_gc_full_();
-		exit(0);
+	// Clock options apply to the game and to replays.
+	Clock vclock = {.mode = CLK_REAL, .frame_ms = FRAME_MS};
+	bool ok = clock_args(&vclock, &argc, argv);
+
+	// `--replay` plays back recorded games. `--simulate` and `--bench` run headless.
+	for (int a = 1; ok && a < argc; a++) {
+		if (!strcmp(argv[a], "--replay")) return replay_main(argc, argv, vclock);
+		if (!strcmp(argv[a], "--build-tablebase")) return tablebase_main(argc, argv);
+		if (!strcmp(argv[a], "--retrograde")) return retrograde_main(argc, argv);
+		if (!strcmp(argv[a], "--simulate") || !strcmp(argv[a], "--bench")) 
+			return simulation_main(argc, argv);
 	}
 
-	// Same with normie.
-	FILE* norfile = fopen("./normie", "r");
-	if (norfile) {
-		fclose(norfile);
-		cls();
-		sleep(1);
-		NORMIE();
-		cls();
-		_gc_full_();
-		exit(0);
+	// Anything else is an option of the game.
+	const char *record = NULL, *metrics_path = NULL, *tablebase_path = NULL;
+	uint64_t seed = 0;
+	bool seeded = false;
+	short retro_threads = 0;
+	const char* strategy_name = NULL;
+	for (int a = 1; ok && a < argc; a += 2) {
+		const char* val = a + 1 < argc ? argv[a + 1] : NULL;
+		if (!strcmp(argv[a], "--seed") && val) seed = strtoull(val, NULL, 10), seeded = true;
+		else if (!strcmp(argv[a], "--record") && val) record = val;
+		else if (!strcmp(argv[a], "--metrics") && val) metrics_path = val;
+		else if (!strcmp(argv[a], "--tablebase") && val) tablebase_path = val;
+		else if (!strcmp(argv[a], "--retro") && val) 
+			retro_threads = atoi(val), ok = retro_threads > 0 && retro_threads <= MAX_THREADS;
+		else if (!strcmp(argv[a], "--strategy") && val) strategy_name = val;
+		else ok = false;
 	}
-	
-	cls();
-	tiny choice;
-	bool started = false;
-		
-	game: INF_LOOP {
-		// Greeting. If started, greet again.
-		started ? puts(MESSAGES[alt_greeting]) : puts(MESSAGES[greeting]);
-		if (!started) started = true;
-
-		puts(MESSAGES[normieness ? nerfed_mode_choice : mode_choice]);
-		fflush(stdout);
-		printf("Choice: ");
-		choice = getn();	
-		switch(choice) {
-			case 0:
-				break game;
-			case 1:
-				normal_mode();
-				break;
-			case 2:
-				impossible_mode(false);
-				break;
-			default:
-				wrong_input(false);
-				break;
-		}
+	// The computer plays by one of them at most.
+	if ((tablebase_path != NULL) + (retro_threads != 0) + (strategy_name != NULL) > 1) ok = false;
+	if (!ok) {
+		fprintf(stderr, "Usage: %s [--clock real|fast|instant] [--frame MS] [--seed S] [--record FILE]\n"
+			"          [--metrics FILE]\n"
+			"          [--tablebase FILE | --retro THREADS | --strategy table|alphabeta|human]\n"
+			"       %s --replay FILE [--game N]\n"
+			"       %s --simulate N ... | --bench NAME ...\n"
+			"       %s --build-tablebase FILE [--heaps N] ...\n"
+			"       %s --retrograde [--pool N] ...\n", argv[0], argv[0], argv[0], argv[0], argv[0]);
+		return 2;
 	}
-	cls();
-	if (choice == 0) { // Discrete
-		puts(MESSAGES[goodbye]);
-		fflush(stdout);
-		sleep(5);
-		cls();
+
+	ReplayLog log;
+	if (record && !replay_open(&log, record, &CLASSIC_RULES)) {
+		fprintf(stderr, "Cannot record to %s: not a replay log of this game.\n", record);
+		return 1;
 	}
-	_gc_full_();
-	return 0;
+
+	// The computer plays from the table instead of the solver. Any table of this game
+	// with heaps of 21 sticks or more will do.
+	Tablebase tablebase;
+	Strategy from_tablebase;
+	if (tablebase_path && (!tablebase_map(&tablebase, tablebase_path) 
+			|| !strategy_tablebase(&from_tablebase, &tablebase, CLASSIC_RULES))) {
+		fprintf(stderr, "Cannot play from %s: not a tablebase of this game.\n", tablebase_path);
+		return 1;
+	}
+
+	// Or from a retrograde solve of the game, on that many threads.
+	Retro retro;
+	Variant variant = {
+		.pool = CLASSIC_RULES.pool,
+		.moves = {CLASSIC_RULES.moves, CLASSIC_RULES.moves},
+		.misere = CLASSIC_RULES.misere
+	};
+	if (retro_threads && !retro_solve(&retro, variant, retro_threads)) {
+		fprintf(stderr, "Out of memory.\n");
+		return 1;
+	}
+
+	FILE* metrics = NULL;
+	if (metrics_path && !(metrics = fopen(metrics_path, "a"))) {
+		fprintf(stderr, "Cannot write metrics to %s.\n", metrics_path);
+		return 1;
+	}
+
+	// All the game's state lives in the session. See matchsticks.h.
+	Session session;
+	session_init(&session, stdin, stdout);
+	session.clock = vclock;
+	if (seeded) rng_seed(&session.rng, seed);
+	if (record) session.record = &log;
+	if (tablebase_path) session.strategy = from_tablebase; // Owns nothing: a copy will do.
+	if (retro_threads) strategy_retro(&session.strategy, &retro);
+
+	// Or however the chosen strategy picks.
+	if (strategy_name && !strategy_named(&session.strategy, strategy_name, &session.solver, seed)) {
+		fprintf(stderr, "No such strategy: %s. Use table, alphabeta or human.\n", strategy_name);
+		session_free(&session);
+		return 2;
+	}
+	if (metrics) {
+		session.metrics.enabled = true;
+		session.metrics.out = metrics;
+		#ifndef _WIN32
+			// No SA_RESTART: a signal cuts a read at the prompt short, so the dump is not held up.
+			metrics_flag = &session.metrics.dump;
+			struct sigaction action = {.sa_handler = on_sigusr1};
+			sigemptyset(&action.sa_mask);
+			sigaction(SIGUSR1, &action, NULL);
+		#endif
+	}
+	session_run(&session);
+	session_free(&session);
+	bool recorded = !record || replay_close(&log);
+	if (!recorded) fprintf(stderr, "Cannot write to %s: games are missing.\n", record);
+	if (metrics) fclose(metrics);
+	if (tablebase_path) tablebase_free(&tablebase);
+	if (retro_threads) retro_free(&retro);
+	return recorded ? 0 : 1;
 }
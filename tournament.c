@@ -0,0 +1,466 @@
+// ==================================================================================== //
+//                                21 Matchsticks: Tournament                            //
+// ==================================================================================== //
+/*!
+	Pits the bots against each other, on every core.
+
+	Every bot plays every bot (itself included) from the HUMAN seat and from the
+	COMPUTER seat, for the same number of games. The games are cut into batches,
+	and each thread takes batches from its own deque, stealing from the others'
+	once it runs dry. Then the whole tournament is run again on 1, 2, 4... threads
+	to show how games/sec scales.
+
+	Usage:
+		tournament.bin [--bots optimal,random,4321] [--games N] [--threads N]
+		               [--batch N] [--seed S] [--pool N] [--moves 1,3,4] [--normal]
+
+	Every batch has its own seed, so the results do not depend on the thread count
+	or on which thread played what. Each run is checked against the first.
+!*/
+
+// ==================================================================================== //
+//                                   Translation Unit                                   //
+// ==================================================================================== //
+
+#include "matchsticks.h"
+
+#include <string.h>		// strcmp, strlen, memcpy
+#include <time.h>		// time
+#include <stdatomic.h>	// atomic_long, atomic_fetch_add, atomic_compare_exchange
+#include <pthread.h>	// pthread_create, pthread_join
+
+// ------------------------------------------------------------------------------------ //
+
+// Preprocessor-level Constants
+#define MAX_BOTS 8
+#define MAX_MATCHUPS (MAX_BOTS * MAX_BOTS)
+
+// ==================================================================================== //
+//                                        Types                                         //
+// ==================================================================================== //
+
+// Some games of one matchup. The unit of work that threads pass around.
+typedef struct {
+	short matchup;		// Index into `Tournament.matchups`.
+	long first_game;	// Games first_game ... first_game + ngames - 1 of the matchup.
+	long ngames;
+} Batch;
+
+// Chase-Lev work-stealing deque. The owner pops from the bottom, thieves take from the
+// top, and only the last batch ever needs a compare-and-swap between them.
+// All batches are pushed before the threads start, so the array never grows.
+typedef struct {
+	atomic_long top, bottom;
+	Batch* batches;
+	long cap;
+} Deque;
+
+// Results of one matchup. Threads add theirs in once, when they finish.
+typedef struct {
+	atomic_long games, moves, wins[2], refusals;
+} Tally;
+
+typedef struct {
+	SimConfig cfg;		// The two bots and the rules. `cfg.ngames` games are played.
+	char name[2][16];	// Of the bot in each seat, for the report.
+} Matchup;
+
+typedef struct {
+	const Solver* solver;
+	Matchup matchups[MAX_MATCHUPS];
+	short nmatchups;
+	long batch_size;
+	uint64_t seed;
+
+	short nthreads;
+	Deque deques[MAX_THREADS];
+	Tally tallies[MAX_MATCHUPS];
+	atomic_long steals;
+} Tournament;
+
+// One thread's view of the tournament.
+typedef struct {
+	Tournament* tour;
+	short id;
+	Rng rng;			// Picks whom to steal from. Games are seeded per batch.
+} Worker;
+
+
+
+// ==================================================================================== //
+//                                 Function Prototypes                                  //
+// ==================================================================================== //
+
+// Deque
+void deque_init(Deque* deque, long cap);
+void deque_push(Deque* deque, Batch batch);
+bool deque_pop(Deque* deque, Batch* batch);
+bool deque_steal(Deque* deque, Batch* batch);
+
+// ------------------------------------------------------------------------------------ //
+
+// Tournament
+void play_batch(Tournament* tour, Rng* rng, Batch batch, SimStats* stats);
+void* worker_main(void* arg);
+double run_tournament(Tournament* tour, short nthreads);
+void print_results(const Tournament* tour);
+
+
+
+// ==================================================================================== //
+//                                   Implementations                                    //
+// ==================================================================================== //
+
+// ------------------------------------------------------------------------------------ //
+//                                  Subsection: Deque                                   //
+// ------------------------------------------------------------------------------------ //
+
+void deque_init(Deque* deque, long cap) {
+	/*
+		@param Deque* deque:	Deque to initialize. Empty.
+		@param long cap:		Most batches it will ever hold.
+	*/
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	deque->batches = malloc((cap ? cap : 1) * sizeof(Batch));
+	deque->cap = cap;
+	if (!deque->batches) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void deque_push(Deque* deque, Batch batch) {
+	/*
+		Adds a batch at the bottom. Owner only.
+
+		@param Deque* deque:	The owner's deque.
+		@param Batch batch:		Batch to add. There must be room.
+	*/
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	deque->batches[bottom] = batch;
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool deque_pop(Deque* deque, Batch* batch) {
+	/*
+		Takes the batch at the bottom. Owner only.
+
+		@param Deque* deque:	The owner's deque.
+		@param Batch* batch:	Where the batch goes.
+		@return bool:			false if the deque was empty, or a thief got the last one.
+	*/
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	if (top > bottom) { // Empty.
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return false;
+	}
+
+	*batch = deque->batches[bottom];
+	if (top < bottom) return true; // More left. No thief can reach this one.
+
+	// The last batch. Race the thieves for it.
+	bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+		memory_order_seq_cst, memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+	return won;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+bool deque_steal(Deque* deque, Batch* batch) {
+	/*
+		Takes the batch at the top. Any thread.
+
+		@param Deque* deque:	Someone else's deque.
+		@param Batch* batch:	Where the batch goes.
+		@return bool:			false if the deque was empty, or another thread won the race.
+	*/
+	long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+	if (top >= bottom) return false;
+
+	*batch = deque->batches[top];
+	return atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+		memory_order_seq_cst, memory_order_relaxed);
+}
+
+
+// ------------------------------------------------------------------------------------ //
+//                                Subsection: Tournament                                //
+// ------------------------------------------------------------------------------------ //
+
+void play_batch(Tournament* tour, Rng* rng, Batch batch, SimStats* stats) {
+	/*
+		Plays the games of one batch. Who picks first alternates with the game number.
+
+		@param Tournament* tour:	The tournament.
+		@param Rng* rng:			Generator of the thread. Reseeded for the batch.
+		@param Batch batch:			Games to play.
+		@param SimStats* stats:		Statistics of the matchup, kept by this thread.
+	*/
+	const SimConfig* cfg = &tour->matchups[batch.matchup].cfg;
+
+	// Seeded by what is played, not by who plays it.
+	rng_seed(rng, tour->seed ^ (uint64_t) batch.matchup << 48 ^ (uint64_t) batch.first_game);
+	for (long n = batch.first_game; n < batch.first_game + batch.ngames; n++) {
+		simulate_game(tour->solver, rng, cfg, (PLAYER) (n & 1), stats);
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void* worker_main(void* arg) {
+	/*
+		Plays batches until there are none left anywhere. Own deque first, then steals.
+		Nothing is shared while playing. The results are added in at the end.
+
+		@param void* arg:	The Worker.
+		@return void*:		NULL.
+	*/
+	Worker* worker = arg;
+	Tournament* tour = worker->tour;
+	Deque* own = &tour->deques[worker->id];
+
+	SimStats* stats = calloc(tour->nmatchups, sizeof(SimStats));
+	Rng game_rng;
+	Batch batch;
+	long nsteals = 0;
+	if (!stats) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(1);
+	}
+
+	INF_LOOP {
+		if (deque_pop(own, &batch)) {
+			play_batch(tour, &game_rng, batch, &stats[batch.matchup]);
+			continue;
+		}
+
+		// Own deque is dry. Go round the others, starting from a random one.
+		// Batches are never added once started, so empty everywhere means done.
+		bool found = false, busy = false;
+		short start = rng_next(&worker->rng) % tour->nthreads;
+		for (short v = 0; v < tour->nthreads && !found; v++) {
+			Deque* victim = &tour->deques[(start + v) % tour->nthreads];
+			if (victim == own) continue;
+			found = deque_steal(victim, &batch);
+			busy |= atomic_load(&victim->top) < atomic_load(&victim->bottom); // Lost a race.
+		}
+		if (found) {
+			nsteals++;
+			play_batch(tour, &game_rng, batch, &stats[batch.matchup]);
+		}
+		else if (!busy) break;
+	}
+
+	// Merge. Lock-free: every field is added with one atomic add.
+	for (short m = 0; m < tour->nmatchups; m++) {
+		Tally* tally = &tour->tallies[m];
+		atomic_fetch_add(&tally->games, stats[m].games);
+		atomic_fetch_add(&tally->moves, stats[m].moves);
+		atomic_fetch_add(&tally->wins[HUMAN], stats[m].wins[HUMAN]);
+		atomic_fetch_add(&tally->wins[COMPUTER], stats[m].wins[COMPUTER]);
+		atomic_fetch_add(&tally->refusals, stats[m].refusals);
+	}
+	atomic_fetch_add(&tour->steals, nsteals);
+	free(stats);
+	return NULL;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+double run_tournament(Tournament* tour, short nthreads) {
+	/*
+		Plays the whole tournament on `nthreads` threads.
+		Batches are dealt in contiguous runs, so matchups of unequal cost end up unevenly
+		spread and stealing has something to even out.
+
+		@param Tournament* tour:	The tournament. Its tallies are reset.
+		@param short nthreads:		Threads to play on. 1 to MAX_THREADS.
+		@return double:				Seconds taken.
+	*/
+	long nbatches = 0;
+	for (short m = 0; m < tour->nmatchups; m++) {
+		long games = tour->matchups[m].cfg.ngames;
+		nbatches += (games + tour->batch_size - 1) / tour->batch_size;
+	}
+
+	tour->nthreads = nthreads;
+	long per_thread = (nbatches + nthreads - 1) / nthreads;
+	for (short t = 0; t < nthreads; t++) deque_init(&tour->deques[t], per_thread);
+	for (short m = 0; m < tour->nmatchups; m++) {
+		Tally* tally = &tour->tallies[m];
+		atomic_init(&tally->games, 0);
+		atomic_init(&tally->moves, 0);
+		atomic_init(&tally->wins[HUMAN], 0);
+		atomic_init(&tally->wins[COMPUTER], 0);
+		atomic_init(&tally->refusals, 0);
+	}
+	atomic_init(&tour->steals, 0);
+
+	long dealt = 0;
+	for (short m = 0; m < tour->nmatchups; m++) {
+		long games = tour->matchups[m].cfg.ngames;
+		for (long g = 0; g < games; g += tour->batch_size, dealt++) {
+			Batch batch = {m, g, games - g < tour->batch_size ? games - g : tour->batch_size};
+			deque_push(&tour->deques[dealt / per_thread], batch);
+		}
+	}
+
+	pthread_t threads[MAX_THREADS];
+	Worker workers[MAX_THREADS];
+	double start = now_seconds();
+	for (short t = 0; t < nthreads; t++) {
+		workers[t] = (Worker) {.tour = tour, .id = t};
+		rng_seed(&workers[t].rng, tour->seed + t);
+		if (pthread_create(&threads[t], NULL, worker_main, &workers[t])) {
+			fprintf(stderr, "Could not start thread %d.\n", t);
+			exit(1);
+		}
+	}
+	for (short t = 0; t < nthreads; t++) pthread_join(threads[t], NULL);
+	double seconds = now_seconds() - start;
+
+	for (short t = 0; t < nthreads; t++) free(tour->deques[t].batches);
+	return seconds;
+}
+
+// ------------------------------------------------------------------------------------ //
+
+void print_results(const Tournament* tour) {
+	/*
+		Prints one row per matchup. Plain text, whitespace separated, easy to diff.
+
+		@param const Tournament* tour:	A tournament that was run.
+	*/
+	printf("%-12s %-12s %10s %9s %9s %9s %8s\n",
+		"human", "computer", "games", "human%", "computer%", "refused%", "moves");
+	for (short m = 0; m < tour->nmatchups; m++) {
+		const Matchup* match = &tour->matchups[m];
+		const Tally* tally = &tour->tallies[m];
+		double games = atomic_load(&tally->games) ? atomic_load(&tally->games) : 1;
+
+		printf("%-12s %-12s %10ld %9.2f %9.2f %9.2f %8.2f\n", match->name[HUMAN],
+			match->name[COMPUTER], atomic_load(&tally->games),
+			100 * atomic_load(&tally->wins[HUMAN]) / games,
+			100 * atomic_load(&tally->wins[COMPUTER]) / games,
+			100 * atomic_load(&tally->refusals) / games, atomic_load(&tally->moves) / games);
+	}
+}
+
+
+
+// |==================================================================================| //
+// |==================================================================================| //
+// |                                       MAIN                                       | //
+// |==================================================================================| //
+// |==================================================================================| //
+
+int main(int argc, char* argv[]) {
+	static Tournament tour; // Too big for the stack.
+	char botlist[128] = "optimal,random";
+	Rules rules = CLASSIC_RULES;
+	long ngames = 100000;
+	short maxthreads = count_cores();
+	tour.batch_size = 1024;
+	tour.seed = time(0);
+
+	for (int a = 1; a < argc; a++) {
+		const char* arg = argv[a];
+		const char* val = a + 1 < argc ? argv[a + 1] : NULL;
+		bool ok = val != NULL;
+
+		if (!strcmp(arg, "--bots") && ok)
+			ok = strlen(val) < sizeof(botlist), strncpy(botlist, val, sizeof(botlist) - 1);
+		else if (!strcmp(arg, "--games") && ok) ngames = atol(val), ok = ngames > 0;
+		else if (!strcmp(arg, "--threads") && ok)
+			maxthreads = atoi(val), ok = maxthreads > 0 && maxthreads <= MAX_THREADS;
+		else if (!strcmp(arg, "--batch") && ok) tour.batch_size = atol(val), ok = tour.batch_size > 0;
+		else if (!strcmp(arg, "--seed") && ok) tour.seed = strtoull(val, NULL, 10);
+		else if (!strcmp(arg, "--pool") && ok) rules.pool = atoll(val), ok = rules.pool > 0;
+		else if (!strcmp(arg, "--moves") && ok) ok = parse_moves(&rules.moves, val);
+		else if (!strcmp(arg, "--normal")) {
+			rules.misere = false;
+			continue; // Takes no value.
+		}
+		else ok = false;
+
+		if (!ok) {
+			fprintf(stderr, "Invalid argument: %s\n", arg);
+			fprintf(stderr, "Usage: %s [--bots optimal,random,4321] [--games N] [--threads N] "
+				"[--batch N] [--seed S] [--pool N] [--moves 1,3,4] [--normal]\n"
+				"\t--games is per matchup. Every bot plays every bot, from both seats.\n", argv[0]);
+			return 2;
+		}
+		a++; // Skip the value.
+	}
+
+	// Bots. parse_seat keeps a pointer to scripts, so they stay in `botlist`.
+	Seat bots[MAX_BOTS];
+	const char* names[MAX_BOTS];
+	short nbots = 0;
+	for (char* name = botlist; name && *name; nbots++) {
+		char* comma = strchr(name, ',');
+		if (comma) *comma = 0;
+		if (nbots == MAX_BOTS || !parse_seat(&bots[nbots], name)) {
+			fprintf(stderr, "Invalid bot: %s (at most %d bots)\n", name, MAX_BOTS);
+			return 2;
+		}
+		names[nbots] = name;
+		name = comma ? comma + 1 : NULL;
+	}
+
+	for (short h = 0; h < nbots; h++) for (short c = 0; c < nbots; c++) {
+		Matchup* match = &tour.matchups[tour.nmatchups++];
+		match->cfg = (SimConfig) {
+			.ngames = ngames, .rules = rules, .seats = {bots[h], bots[c]}, .first = -1
+		};
+		snprintf(match->name[HUMAN], sizeof(match->name[HUMAN]), "%s", names[h]);
+		snprintf(match->name[COMPUTER], sizeof(match->name[COMPUTER]), "%s", names[c]);
+	}
+
+	Solver solver;
+	solver_init(&solver, rules);
+	tour.solver = &solver;
+
+	// The full tournament on every core first, then the scaling runs.
+	printf("# seed %llu, %ld games per matchup, batches of %ld\n", (unsigned long long) tour.seed, 
+		ngames, tour.batch_size);
+	run_tournament(&tour, maxthreads);
+	print_results(&tour);
+
+	long reference[MAX_MATCHUPS][2];
+	for (short m = 0; m < tour.nmatchups; m++) {
+		reference[m][HUMAN] = atomic_load(&tour.tallies[m].wins[HUMAN]);
+		reference[m][COMPUTER] = atomic_load(&tour.tallies[m].wins[COMPUTER]);
+	}
+
+	printf("\n%-8s %10s %14s %8s %8s %6s\n", "threads", "seconds", "games/sec", "speedup", "steals", "agree");
+	double base = 0;
+	for (short t = 1; t <= maxthreads; t = t < maxthreads && t * 2 > maxthreads ? maxthreads : t * 2) {
+		double seconds = run_tournament(&tour, t);
+		bool agree = true;
+		for (short m = 0; m < tour.nmatchups; m++) {
+			agree &= reference[m][HUMAN] == atomic_load(&tour.tallies[m].wins[HUMAN]);
+			agree &= reference[m][COMPUTER] == atomic_load(&tour.tallies[m].wins[COMPUTER]);
+		}
+		if (t == 1) base = seconds;
+		printf("%-8d %10.3f %14.0f %8.2f %8ld %6s\n", t, seconds,
+			ngames * tour.nmatchups / seconds, base / seconds, atomic_load(&tour.steals),
+			agree ? "yes" : "NO");
+		if (t == maxthreads) break;
+	}
+
+	solver_free(&solver);
+	return 0;
+}